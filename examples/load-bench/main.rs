@@ -0,0 +1,109 @@
+//! Benchmarks database loading: raw file read versus initialization, from plain and (possibly) compressed files, Rust-side scanning of nuclide headers and lazy initialization
+//!
+//! `sdecay` is built with `gzip` and `zstd` features, so decompression of `.gz`/`.zst` databases is measured as well
+#![allow(missing_docs)]
+
+use std::{
+    hint::black_box,
+    path::PathBuf,
+    time::{Duration, Instant},
+};
+
+use anyhow::Context;
+use clap::Parser;
+use sdecay::{
+    SharedDatabase, compression::CompressedLoader, lazy_database::LazyDatabase, nuclide,
+    scan::nuclide_headers,
+};
+
+#[derive(Debug, Parser)]
+struct Args {
+    /// Database file, plain or compressed
+    #[arg(long("decay-data"), default_value = "sandia.decay.xml")]
+    path: PathBuf,
+    /// Number of iterations for each measurement
+    #[arg(long, default_value_t = 5)]
+    iterations: u32,
+}
+
+fn bench<T>(
+    name: &str,
+    iterations: u32,
+    mut f: impl FnMut() -> anyhow::Result<T>,
+) -> anyhow::Result<()> {
+    let mut best = Duration::MAX;
+    let mut total = Duration::ZERO;
+    for _ in 0..iterations {
+        let start = Instant::now();
+        black_box(f().with_context(|| format!("running {name}"))?);
+        let elapsed = start.elapsed();
+        best = best.min(elapsed);
+        total += elapsed;
+    }
+    println!(
+        "{name:<32} best {best:>12.3?}   mean {:>12.3?}",
+        total / iterations.max(1)
+    );
+    Ok(())
+}
+
+fn main() -> anyhow::Result<()> {
+    let args = Args::try_parse().context("parsing clargs")?;
+    let loader = CompressedLoader::new();
+    let raw = std::fs::read(&args.path).context("reading database")?;
+    println!(
+        "{}: {} bytes, {:?}",
+        args.path.display(),
+        raw.len(),
+        sdecay::compression::Compression::detect(&raw)
+    );
+
+    bench("read file", args.iterations, || {
+        Ok(std::fs::read(&args.path)?)
+    })?;
+    bench("read + decompress", args.iterations, || {
+        Ok(loader.decompress_path(&args.path)?)
+    })?;
+    bench("decompress from memory", args.iterations, || {
+        Ok(loader.decompress_bytes(&raw)?.len())
+    })?;
+    bench("init from path", args.iterations, || {
+        let database: SharedDatabase = loader.load_path(&args.path)?;
+        Ok(database.nuclide(nuclide!(Co - 60)).half_life)
+    })?;
+    bench("init from memory", args.iterations, || {
+        let database: SharedDatabase = loader.load_bytes(&raw)?;
+        Ok(database.nuclide(nuclide!(Co - 60)).half_life)
+    })?;
+
+    // below, every workload starts from the same decompressed XML in memory; note, that they produce different amount of data, so these are not interchangeable
+    let decompressed = loader.decompress_bytes(&raw)?;
+    let xml = std::str::from_utf8(&decompressed)
+        .context("database should be utf-8")?
+        .trim_end_matches('\0');
+    println!("from decompressed XML in memory:");
+    bench("init, whole database", args.iterations, || {
+        let database = SharedDatabase::from_bytes(xml)?;
+        Ok(database.nuclide(nuclide!(Co - 60)).half_life)
+    })?;
+    bench("scan nuclide headers only", args.iterations, || {
+        let mut half_lives = 0.0;
+        for header in nuclide_headers(xml) {
+            half_lives += header?.half_life;
+        }
+        Ok(half_lives)
+    })?;
+    bench("lazy init, no particles", args.iterations, || {
+        Ok(LazyDatabase::from_xml(xml.to_owned())?.num_transitions())
+    })?;
+    bench("lazy init, all particles", args.iterations, || {
+        let database = LazyDatabase::from_xml(xml.to_owned())?;
+        for nuclide in database.nuclides() {
+            for transition in nuclide.transitions() {
+                transition.particles()?;
+            }
+        }
+        Ok(database.num_materialized())
+    })?;
+    Ok(())
+}
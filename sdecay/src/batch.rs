@@ -0,0 +1,407 @@
+//! Batch evaluation of many solved mixtures, sharing exponentials between them
+//!
+//! Mixtures of similar composition share most of their decay constants, so evaluating each of them separately computes the same exponentials over and over. [`SharedExponentials`] collects unique evolution exponents of a batch of [`SolvedMixture`]s once; evaluation at time $t$ computes $e^{-k t}$ for each unique $k$ in a single contiguous sweep, and then evaluates every mixture by gathering from this table.
+//!
+//! For total activity, coefficients of each mixture are additionally pre-summed per unique exponent, so total activity of a mixture costs one multiply-add per distinct exponent it has.
+//!
+//! [`MixtureBatch`] goes further for large batches of similar mixtures, evaluated at a single time: coefficients are stored nuclide-major, contiguous across mixtures, so evaluation is a sequence of `out[..] += coefficients[..] * exp` sweeps over all the mixtures at once. These loops are trivially vectorized by the compiler, and are split between threads by mixture (or nuclide) ranges.
+//!
+//! Unsafe: no
+
+use alloc::{
+    collections::{BTreeMap, BTreeSet},
+    vec::Vec,
+};
+use core::ops::Range;
+
+use crate::{lines::nuclide_key, parallel, solved::SolvedMixture, wrapper::Nuclide};
+
+/// Unique exponents of a batch of solved mixtures, see [module-level docs](self)
+#[derive(Debug, Clone)]
+pub struct SharedExponentials {
+    exponents: Vec<f64>,
+    /// Offsets into `totals` for each mixture
+    total_offsets: Vec<usize>,
+    /// `(exponent index, activity coefficient)`, combined per exponent
+    totals: Vec<(u32, f64)>,
+    /// Offsets into `term_offsets` for each mixture (i.e. solution nuclide offsets)
+    nuclide_offsets: Vec<usize>,
+    /// Offsets into `terms` for each nuclide of each mixture
+    term_offsets: Vec<usize>,
+    /// `(exponent index, activity coefficient)` of each term
+    terms: Vec<(u32, f64)>,
+}
+
+impl SharedExponentials {
+    /// Collects unique exponents of the `mixtures`
+    ///
+    /// Mixtures are only read here; batch does not borrow them
+    pub fn new<'m, 'l: 'm>(mixtures: impl IntoIterator<Item = &'m SolvedMixture<'l>>) -> Self {
+        let mixtures = mixtures.into_iter().collect::<Vec<_>>();
+        let mut exponents = mixtures
+            .iter()
+            .flat_map(|mixture| (0..mixture.len()).flat_map(|index| mixture.terms(index).1))
+            .copied()
+            .collect::<Vec<_>>();
+        exponents.sort_by(f64::total_cmp);
+        exponents.dedup_by(|a, b| a.total_cmp(b).is_eq());
+        let exponent_index = |k: f64| {
+            exponents
+                .binary_search_by(|probe| probe.total_cmp(&k))
+                .expect("all exponents were collected") as u32
+        };
+
+        let mut total_offsets = alloc::vec![0];
+        let mut totals = Vec::new();
+        let mut nuclide_offsets = alloc::vec![0];
+        let mut term_offsets = alloc::vec![0];
+        let mut terms = Vec::new();
+        for mixture in mixtures {
+            let start = totals.len();
+            for (index, &lambda) in mixture.decay_constants().iter().enumerate() {
+                let (coefficients, exps) = mixture.terms(index);
+                for (&c, &k) in coefficients.iter().zip(exps) {
+                    let term = (exponent_index(k), c * lambda);
+                    terms.push(term);
+                    totals.push(term);
+                }
+                term_offsets.push(terms.len());
+            }
+            nuclide_offsets.push(term_offsets.len() - 1);
+            totals[start..].sort_unstable_by_key(|&(index, _)| index);
+            let mut write = start;
+            for read in start..totals.len() {
+                if write > start && totals[write - 1].0 == totals[read].0 {
+                    totals[write - 1].1 += totals[read].1;
+                } else {
+                    totals[write] = totals[read];
+                    write += 1;
+                }
+            }
+            totals.truncate(write);
+            total_offsets.push(totals.len());
+        }
+        Self {
+            exponents,
+            total_offsets,
+            totals,
+            nuclide_offsets,
+            term_offsets,
+            terms,
+        }
+    }
+
+    /// Number of mixtures in the batch
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.total_offsets.len() - 1
+    }
+
+    /// Checks if batch has no mixtures
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Unique exponents, in ascending order
+    #[inline]
+    pub fn exponents(&self) -> &[f64] {
+        &self.exponents
+    }
+
+    /// Range of activities of the `mixture` in [`SharedExponentials::activities_into`] output; solution nuclides are in the same order, as in the mixture
+    ///
+    /// ### Panics
+    /// If `mixture` is out of bounds
+    #[inline]
+    pub fn activity_range(&self, mixture: usize) -> Range<usize> {
+        self.nuclide_offsets[mixture]..self.nuclide_offsets[mixture + 1]
+    }
+
+    /// Total number of solution nuclides of all the mixtures
+    #[inline]
+    pub fn num_activities(&self) -> usize {
+        self.term_offsets.len() - 1
+    }
+
+    /// Computes $e^{-k t}$ for every unique exponent into `table`
+    ///
+    /// ### Panics
+    /// If `table` length is not equal to number of [`SharedExponentials::exponents`]
+    pub fn exponentials_into(&self, time: f64, table: &mut [f64]) {
+        assert_eq!(
+            table.len(),
+            self.exponents.len(),
+            "table should match exponents"
+        );
+        for (e, k) in table.iter_mut().zip(&self.exponents) {
+            *e = (-k * time).exp();
+        }
+    }
+
+    /// Writes total activities of all the mixtures at all the `times` into `out`, mixture-major (`out[mixture * times.len() + time]`)
+    ///
+    /// Exponentials are computed once per unique exponent and time
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to number of mixtures times number of `times`
+    pub fn total_activities_into(&self, times: &[f64], out: &mut [f64]) {
+        assert_eq!(
+            out.len(),
+            self.len() * times.len(),
+            "output should match mixtures and times"
+        );
+        let mut table = alloc::vec![0.0; self.exponents.len()];
+        for (t, &time) in times.iter().enumerate() {
+            self.exponentials_into(time, &mut table);
+            for mixture in 0..self.len() {
+                out[mixture * times.len() + t] = gather(
+                    &self.totals[self.total_offsets[mixture]..self.total_offsets[mixture + 1]],
+                    &table,
+                );
+            }
+        }
+    }
+
+    /// Writes activities of solution nuclides of all the mixtures at `time` into `out`, see [`SharedExponentials::activity_range`]
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`SharedExponentials::num_activities`]
+    pub fn activities_into(&self, time: f64, out: &mut [f64]) {
+        assert_eq!(
+            out.len(),
+            self.num_activities(),
+            "output should match nuclides"
+        );
+        let mut table = alloc::vec![0.0; self.exponents.len()];
+        self.exponentials_into(time, &mut table);
+        for (nuclide, out) in out.iter_mut().enumerate() {
+            *out = gather(
+                &self.terms[self.term_offsets[nuclide]..self.term_offsets[nuclide + 1]],
+                &table,
+            );
+        }
+    }
+}
+
+/// Sums coefficients, weighted by exponentials from `table`
+#[inline]
+fn gather(terms: &[(u32, f64)], table: &[f64]) -> f64 {
+    terms
+        .iter()
+        .map(|&(index, c)| c * table[index as usize])
+        .sum()
+}
+
+/// Many solved mixtures in nuclide-major layout, see [module-level docs](self)
+///
+/// Storage is dense: every mixture has a coefficient for every `(nuclide, exponent)` pair present in any of the mixtures. This is best suited for batches of mixtures with similar compositions
+#[derive(Debug, Clone)]
+pub struct MixtureBatch<'l> {
+    mixtures: usize,
+    nuclides: Vec<&'l Nuclide<'l>>,
+    exponents: Vec<f64>,
+    /// Column offsets of each nuclide
+    nuclide_columns: Vec<usize>,
+    /// Exponent index of each column
+    column_exponents: Vec<u32>,
+    /// Activity coefficients, `mixtures` per column
+    coefficients: Vec<f64>,
+    /// Total activity coefficients, `mixtures` per exponent
+    totals: Vec<f64>,
+}
+
+impl<'l> MixtureBatch<'l> {
+    /// Lays out the `mixtures`
+    pub fn new<'m>(mixtures: impl IntoIterator<Item = &'m SolvedMixture<'l>>) -> Self
+    where
+        'l: 'm,
+    {
+        let mixtures = mixtures.into_iter().collect::<Vec<_>>();
+        // `(nuclide key, exponent bits)` -> column, ordered by nuclide
+        let mut nuclide_positions = BTreeMap::new();
+        let mut nuclides = Vec::new();
+        let mut pairs = BTreeSet::new();
+        let mut exponents = Vec::new();
+        for mixture in &mixtures {
+            for (index, &nuclide) in mixture.nuclides().iter().enumerate() {
+                let position = *nuclide_positions
+                    .entry(nuclide_key(nuclide))
+                    .or_insert_with(|| {
+                        nuclides.push(nuclide);
+                        nuclides.len() - 1
+                    });
+                for &k in mixture.terms(index).1 {
+                    pairs.insert((position, k.to_bits()));
+                    exponents.push(k);
+                }
+            }
+        }
+        exponents.sort_by(f64::total_cmp);
+        exponents.dedup_by(|a, b| a.total_cmp(b).is_eq());
+        let exponent_index = |k: f64| {
+            exponents
+                .binary_search_by(|probe| probe.total_cmp(&k))
+                .expect("all exponents were collected")
+        };
+
+        let mut nuclide_columns = alloc::vec![0; nuclides.len() + 1];
+        let mut column_exponents = Vec::with_capacity(pairs.len());
+        let mut columns = BTreeMap::new();
+        for (column, &(position, bits)) in pairs.iter().enumerate() {
+            nuclide_columns[position + 1] = column + 1;
+            column_exponents.push(exponent_index(f64::from_bits(bits)) as u32);
+            columns.insert((position, bits), column);
+        }
+        for position in 1..nuclide_columns.len() {
+            nuclide_columns[position] =
+                nuclide_columns[position].max(nuclide_columns[position - 1]);
+        }
+
+        let count = mixtures.len();
+        let mut coefficients = alloc::vec![0.0; column_exponents.len() * count];
+        let mut totals = alloc::vec![0.0; exponents.len() * count];
+        for (m, mixture) in mixtures.iter().enumerate() {
+            for (index, (&nuclide, &lambda)) in mixture
+                .nuclides()
+                .iter()
+                .zip(mixture.decay_constants())
+                .enumerate()
+            {
+                let position = nuclide_positions[&nuclide_key(nuclide)];
+                let (cs, ks) = mixture.terms(index);
+                for (&c, &k) in cs.iter().zip(ks) {
+                    let column = columns[&(position, k.to_bits())];
+                    coefficients[column * count + m] += c * lambda;
+                    totals[exponent_index(k) * count + m] += c * lambda;
+                }
+            }
+        }
+        Self {
+            mixtures: count,
+            nuclides,
+            exponents,
+            nuclide_columns,
+            column_exponents,
+            coefficients,
+            totals,
+        }
+    }
+
+    /// Number of mixtures in the batch
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.mixtures
+    }
+
+    /// Checks if batch has no mixtures
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.mixtures == 0
+    }
+
+    /// Solution nuclides of all the mixtures, in order of first appearance; these are the rows of [`MixtureBatch::activities_into`] output
+    #[inline]
+    pub fn nuclides(&self) -> &[&'l Nuclide<'l>] {
+        &self.nuclides
+    }
+
+    /// Total activities of all the mixtures at `time`
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`MixtureBatch::len`]
+    pub fn total_activities_into(&self, time: f64, out: &mut [f64]) {
+        assert_eq!(out.len(), self.mixtures, "output should match mixtures");
+        let table = self.exponentials(time);
+        self.totals_range(&table, 0, out);
+    }
+
+    /// Same as [`MixtureBatch::total_activities_into`], but mixtures are split between `threads`
+    ///
+    /// Exponentials are evaluated once, and shared between the threads
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`MixtureBatch::len`]
+    pub fn total_activities_parallel(&self, time: f64, out: &mut [f64], threads: usize) {
+        assert_eq!(out.len(), self.mixtures, "output should match mixtures");
+        if self.mixtures == 0 {
+            return;
+        }
+        let table = self.exponentials(time);
+        parallel::for_each_mut(out, 1, threads, |mixtures, out| {
+            self.totals_range(&table, mixtures.start, out);
+        });
+    }
+
+    /// Activities of all the [`MixtureBatch::nuclides`] in all the mixtures at `time`, nuclide-major (`out[nuclide * len + mixture]`)
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to number of nuclides times [`MixtureBatch::len`]
+    pub fn activities_into(&self, time: f64, out: &mut [f64]) {
+        assert_eq!(
+            out.len(),
+            self.nuclides.len() * self.mixtures,
+            "output should match nuclides and mixtures"
+        );
+        let table = self.exponentials(time);
+        self.activities_rows(&table, 0, out);
+    }
+
+    /// Same as [`MixtureBatch::activities_into`], but nuclides are split between `threads`
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to number of nuclides times [`MixtureBatch::len`]
+    pub fn activities_parallel(&self, time: f64, out: &mut [f64], threads: usize) {
+        assert_eq!(
+            out.len(),
+            self.nuclides.len() * self.mixtures,
+            "output should match nuclides and mixtures"
+        );
+        if out.is_empty() {
+            return;
+        }
+        let table = self.exponentials(time);
+        parallel::for_each_mut(out, self.mixtures, threads, |nuclides, out| {
+            self.activities_rows(&table, nuclides.start, out);
+        });
+    }
+
+    fn exponentials(&self, time: f64) -> Vec<f64> {
+        self.exponents.iter().map(|k| (-k * time).exp()).collect()
+    }
+
+    /// Total activities of mixtures, starting at `first`, given exponentials `table`
+    fn totals_range(&self, table: &[f64], first: usize, out: &mut [f64]) {
+        out.fill(0.0);
+        for (exponent, &e) in table.iter().enumerate() {
+            let start = exponent * self.mixtures + first;
+            axpy(e, &self.totals[start..start + out.len()], out);
+        }
+    }
+
+    /// Activity rows of nuclides, starting at `first`
+    fn activities_rows(&self, table: &[f64], first: usize, out: &mut [f64]) {
+        assert_eq!(
+            out.len() % self.mixtures.max(1),
+            0,
+            "output should consist of whole rows"
+        );
+        for (row, out) in out.chunks_exact_mut(self.mixtures.max(1)).enumerate() {
+            let nuclide = first + row;
+            out.fill(0.0);
+            for column in self.nuclide_columns[nuclide]..self.nuclide_columns[nuclide + 1] {
+                let e = table[self.column_exponents[column] as usize];
+                let start = column * self.mixtures;
+                axpy(e, &self.coefficients[start..start + self.mixtures], out);
+            }
+        }
+    }
+}
+
+/// `out += a * x`
+#[inline]
+fn axpy(a: f64, x: &[f64], out: &mut [f64]) {
+    for (out, x) in out.iter_mut().zip(x) {
+        *out += a * x;
+    }
+}
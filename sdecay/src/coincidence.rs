@@ -0,0 +1,445 @@
+//! Native true-coincidence summing corrections, computed from [`RadParticle::coincidences`](crate::wrapper::RadParticle::coincidences) data
+//!
+//! Computation is split into three stages:
+//! - [`CoincidenceTable`] holds sparse $\gamma$-$\gamma$ coincidence matrices for each nuclide. It is built once per database and does not depend on the detector
+//! - [`SummingCorrections`] is obtained from [`CoincidenceTable::with_efficiencies`] and holds per-line summing factors for a specific detector (peak and total efficiency curves)
+//! - [`SummingCorrections::corrections`] scales these factors by nuclide activities of a mixture, producing per-line rates and corrections
+//!
+//! Unsafe: no
+
+use alloc::{collections::BTreeMap, vec::Vec};
+
+pub use crate::efficiency::EfficiencyCurve;
+use crate::{
+    lines::nuclide_key,
+    wrapper::{
+        CoincidencePair, Nuclide, NuclideActivityPair, NuclideMixture, ProductTypeD, RadParticle,
+        SandiaDecayDataBase, Transition,
+    },
+};
+
+/// A single $\gamma$ line of a nuclide
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct CoincidenceLine {
+    /// Line energy, in `SandiaDecay` units
+    pub energy: f64,
+    /// Number of photons emitted per decay of the nuclide (i.e. branching ratio times particle intensity)
+    pub intensity: f64,
+}
+
+/// Sparse $\gamma$-$\gamma$ coincidence matrix of a single nuclide
+///
+/// Rows and columns correspond to [`NuclideCoincidences::lines`]. Element $c_{ij}$ is the fraction of times line $j$ is emitted along with line $i$
+#[derive(Debug)]
+pub struct NuclideCoincidences<'l> {
+    nuclide: &'l Nuclide<'l>,
+    matrix: CoincidenceMatrix,
+}
+
+/// Lines and compressed sparse rows of a coincidence matrix, see [`NuclideCoincidences`]
+#[derive(Debug)]
+pub(crate) struct CoincidenceMatrix {
+    lines: Vec<CoincidenceLine>,
+    row_offsets: Vec<usize>,
+    columns: Vec<u32>,
+    fractions: Vec<f64>,
+}
+
+impl<'l> NuclideCoincidences<'l> {
+    /// Builds coincidence matrix for a `nuclide` from it's decay [`Transition`]s
+    pub fn new(nuclide: &'l Nuclide<'l>) -> Self {
+        let mut lines = Vec::new();
+        let mut row_offsets = Vec::new();
+        let mut columns = Vec::new();
+        let mut fractions = Vec::new();
+        // line index of each transition's product, if it happens to be a gamma
+        let mut product_lines = Vec::new();
+        for transition in &nuclide.decays_to_children {
+            let Transition {
+                branch_ratio,
+                products,
+                ..
+            } = transition;
+            let products = products.as_slice();
+            product_lines.clear();
+            for particle in products {
+                if particle.r#type.d() == ProductTypeD::GammaParticle {
+                    product_lines.push(Some(lines.len() as u32));
+                    lines.push(CoincidenceLine {
+                        energy: f64::from(particle.energy),
+                        intensity: f64::from(*branch_ratio) * f64::from(particle.intensity),
+                    });
+                } else {
+                    product_lines.push(None);
+                }
+            }
+            for (particle, line) in products.iter().zip(&product_lines) {
+                if line.is_none() {
+                    continue;
+                }
+                row_offsets.push(columns.len());
+                let RadParticle { coincidences, .. } = particle;
+                for &CoincidencePair(index, fraction) in coincidences {
+                    // coincidences are only meaningful for gammas of the same transition
+                    let Some(&Some(column)) = product_lines.get(usize::from(index)) else {
+                        continue;
+                    };
+                    columns.push(column);
+                    fractions.push(f64::from(fraction));
+                }
+            }
+        }
+        row_offsets.push(columns.len());
+        Self {
+            nuclide,
+            matrix: CoincidenceMatrix {
+                lines,
+                row_offsets,
+                columns,
+                fractions,
+            },
+        }
+    }
+
+    /// Nuclide this matrix was built for
+    #[inline]
+    pub fn nuclide(&self) -> &'l Nuclide<'l> {
+        self.nuclide
+    }
+
+    /// $\gamma$ lines of the nuclide, in order they appear in the database
+    #[inline]
+    pub fn lines(&self) -> &[CoincidenceLine] {
+        &self.matrix.lines
+    }
+
+    /// Total number of non-zero coincidence fractions
+    #[inline]
+    pub fn num_coincidences(&self) -> usize {
+        self.matrix.columns.len()
+    }
+
+    /// Returns an iterator over lines coincident with the line at `index`, along with coincidence fraction
+    ///
+    /// ### Panics
+    /// If `index` is out of bounds of [`NuclideCoincidences::lines`]
+    #[inline]
+    pub fn coincident_with(
+        &self,
+        index: usize,
+    ) -> impl ExactSizeIterator<Item = (usize, f64)> + '_ {
+        self.matrix.coincident_with(index)
+    }
+}
+
+impl CoincidenceMatrix {
+    /// Builds matrix from `lines` and a row of `(column, fraction)` pairs for each of them
+    #[cfg(test)]
+    pub(crate) fn from_rows(lines: Vec<CoincidenceLine>, rows: &[&[(u32, f64)]]) -> Self {
+        assert_eq!(lines.len(), rows.len(), "every line should have a row");
+        let mut row_offsets = Vec::with_capacity(rows.len() + 1);
+        let mut columns = Vec::new();
+        let mut fractions = Vec::new();
+        for row in rows {
+            row_offsets.push(columns.len());
+            for &(column, fraction) in *row {
+                columns.push(column);
+                fractions.push(fraction);
+            }
+        }
+        row_offsets.push(columns.len());
+        Self {
+            lines,
+            row_offsets,
+            columns,
+            fractions,
+        }
+    }
+
+    fn coincident_with(&self, index: usize) -> impl ExactSizeIterator<Item = (usize, f64)> + '_ {
+        let range = self.row_offsets[index]..self.row_offsets[index + 1];
+        self.columns[range.clone()]
+            .iter()
+            .zip(&self.fractions[range])
+            .map(|(&column, &fraction)| (column as usize, fraction))
+    }
+
+    /// Evaluates summing factors of the lines, see [`CoincidenceTable::with_efficiencies`]
+    ///
+    /// `peak` and `total` are efficiencies at line energies. Summing-out factors are appended to `summing_out`, summing-in contributions are added to `summing_in` (of the same length as lines)
+    pub(crate) fn summing(
+        &self,
+        peak: &[f64],
+        total: &[f64],
+        sum_tolerance: f64,
+        summing_in: &mut [f64],
+        summing_out: &mut Vec<f64>,
+    ) {
+        // each unordered cascade pair sums in once, whether it's listed in one row or in both; row of the lower-index line is preferred
+        let mut pairs = BTreeMap::new();
+        for (i, line) in self.lines.iter().enumerate() {
+            let mut lost = 0.0;
+            for (j, fraction) in self.coincident_with(i) {
+                lost += fraction * total[j];
+                if j == i {
+                    continue;
+                }
+                let summed_rate = line.intensity * fraction * peak[i] * peak[j];
+                let pair = (i.min(j), i.max(j));
+                if i < j {
+                    pairs.insert(pair, summed_rate);
+                } else {
+                    pairs.entry(pair).or_insert(summed_rate);
+                }
+            }
+            summing_out.push((1.0 - lost).max(0.0));
+        }
+        for ((i, j), summed_rate) in pairs {
+            let sum_energy = self.lines[i].energy + self.lines[j].energy;
+            for (k, target) in self.lines.iter().enumerate() {
+                if (target.energy - sum_energy).abs() <= sum_tolerance {
+                    summing_in[k] += summed_rate;
+                }
+            }
+        }
+    }
+}
+
+/// Collection of [`NuclideCoincidences`], independent of the detector
+#[derive(Debug)]
+pub struct CoincidenceTable<'l> {
+    // sorted by nuclide address, to allow binary search
+    nuclides: Vec<NuclideCoincidences<'l>>,
+}
+
+impl<'l> CoincidenceTable<'l> {
+    /// Builds coincidence matrices for every nuclide in the database that emits any $\gamma$
+    pub fn new(database: &'l SandiaDecayDataBase) -> Self {
+        Self::from_nuclides(database.nuclides().iter().copied())
+    }
+
+    /// Builds coincidence matrices for specified nuclides only
+    ///
+    /// Nuclides without $\gamma$ lines are skipped, duplicates are ignored
+    pub fn from_nuclides(nuclides: impl IntoIterator<Item = &'l Nuclide<'l>>) -> Self {
+        let mut nuclides = nuclides
+            .into_iter()
+            .map(NuclideCoincidences::new)
+            .filter(|coincidences| !coincidences.lines().is_empty())
+            .collect::<Vec<_>>();
+        nuclides.sort_unstable_by_key(|coincidences| nuclide_key(coincidences.nuclide));
+        nuclides.dedup_by_key(|coincidences| nuclide_key(coincidences.nuclide));
+        Self { nuclides }
+    }
+
+    /// Coincidence matrix for the `nuclide`
+    ///
+    /// ### Returns
+    /// [`Option::None`] indicates that nuclide is not present in the table (it has no $\gamma$ lines, or was not requested)
+    pub fn get(&self, nuclide: &Nuclide<'_>) -> Option<&NuclideCoincidences<'l>> {
+        self.position(nuclide).map(|index| &self.nuclides[index])
+    }
+
+    fn position(&self, nuclide: &Nuclide<'_>) -> Option<usize> {
+        let key = nuclide_key(nuclide);
+        self.nuclides
+            .binary_search_by_key(&key, |coincidences| nuclide_key(coincidences.nuclide))
+            .ok()
+    }
+
+    /// Returns an iterator over all contained matrices
+    #[inline]
+    pub fn iter(&self) -> impl ExactSizeIterator<Item = &NuclideCoincidences<'l>> {
+        self.nuclides.iter()
+    }
+
+    /// Evaluates per-line summing factors for a specific detector
+    ///
+    /// - `peak` is a full-energy peak efficiency
+    /// - `total` is a total efficiency (i.e. probability of depositing any energy in the detector)
+    /// - `sum_tolerance` is a maximum difference between sum of two coincident line energies and a line energy, for the pair to be considered summing into this line
+    ///
+    /// Summing-out factor of line $i$ is
+    /// $$
+    /// S^{out}\_i = 1 - \sum_j c_{ij} \varepsilon^{t}(E_j),
+    /// $$
+    /// while summing-in contribution (per decay) is
+    /// $$
+    /// S^{in}\_i = \sum_{j < k,\ |E_j + E_k - E_i| \le \delta} I_j c_{jk} \varepsilon^{p}(E_j) \varepsilon^{p}(E_k)
+    /// $$
+    /// Each unordered pair is counted once. If the pair is only listed in the row of the higher-index line $k$, $I_k c_{kj}$ is used instead
+    pub fn with_efficiencies(
+        &self,
+        peak: &impl EfficiencyCurve,
+        total: &impl EfficiencyCurve,
+        sum_tolerance: f64,
+    ) -> SummingCorrections<'_, 'l> {
+        let mut offsets = Vec::with_capacity(self.nuclides.len() + 1);
+        let mut intensities = Vec::new();
+        let mut peak_efficiencies = Vec::new();
+        let mut summing_out = Vec::new();
+        let mut summing_in = Vec::new();
+        let mut total_efficiencies = Vec::new();
+        for coincidences in &self.nuclides {
+            offsets.push(intensities.len());
+            let base = intensities.len();
+            total_efficiencies.clear();
+            for line in coincidences.lines() {
+                intensities.push(line.intensity);
+                peak_efficiencies.push(peak.efficiency(line.energy));
+                total_efficiencies.push(total.efficiency(line.energy));
+            }
+            summing_in.resize(intensities.len(), 0.0);
+            coincidences.matrix.summing(
+                &peak_efficiencies[base..],
+                &total_efficiencies,
+                sum_tolerance,
+                &mut summing_in[base..],
+                &mut summing_out,
+            );
+        }
+        offsets.push(intensities.len());
+        SummingCorrections {
+            table: self,
+            offsets,
+            intensities,
+            peak_efficiencies,
+            summing_out,
+            summing_in,
+        }
+    }
+}
+
+/// Per-line summing factors for a specific detector
+///
+/// Obtained from [`CoincidenceTable::with_efficiencies`]. All the arrays are stored flat (line-major, in the order of [`CoincidenceTable::iter`]), so that applying them to a mixture is a single pass over contiguous memory
+#[derive(Debug)]
+pub struct SummingCorrections<'t, 'l> {
+    table: &'t CoincidenceTable<'l>,
+    offsets: Vec<usize>,
+    intensities: Vec<f64>,
+    peak_efficiencies: Vec<f64>,
+    summing_out: Vec<f64>,
+    summing_in: Vec<f64>,
+}
+
+/// Summing correction for a single line emitted by a mixture
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct SummingCorrection<'l> {
+    /// Nuclide emitting the line
+    pub nuclide: &'l Nuclide<'l>,
+    /// Line energy
+    pub energy: f64,
+    /// Emission rate of the line
+    pub rate: f64,
+    /// Full-energy peak rate, in absence of coincidence summing
+    pub peak_rate: f64,
+    /// Rate lost from the peak due to summing-out
+    pub summing_out_rate: f64,
+    /// Rate added to the peak due to summing-in
+    pub summing_in_rate: f64,
+}
+
+impl SummingCorrection<'_> {
+    /// Expected peak rate, accounting for coincidence summing
+    #[inline]
+    pub fn observed_rate(&self) -> f64 {
+        self.peak_rate - self.summing_out_rate + self.summing_in_rate
+    }
+
+    /// Correction factor, i.e. the ratio of observed peak rate to the rate in absence of coincidence summing
+    ///
+    /// To obtain true emission rate, divide observed peak area by this factor (and peak efficiency)
+    ///
+    /// ### Returns
+    /// `1.0` for lines with zero peak rate
+    #[inline]
+    pub fn factor(&self) -> f64 {
+        if self.peak_rate == 0.0 {
+            1.0
+        } else {
+            self.observed_rate() / self.peak_rate
+        }
+    }
+}
+
+impl<'l> SummingCorrections<'_, 'l> {
+    /// Correction factors for every line of the `nuclide`, in order of [`NuclideCoincidences::lines`]
+    ///
+    /// These are independent of the activity, so might be used for any mixture
+    ///
+    /// ### Returns
+    /// [`Option::None`] indicates that nuclide is not present in the underlying [`CoincidenceTable`]
+    pub fn nuclide_factors(&self, nuclide: &Nuclide<'_>) -> Option<Vec<f64>> {
+        let index = self.table.position(nuclide)?;
+        let range = self.offsets[index]..self.offsets[index + 1];
+        Some(
+            self.summing_out[range.clone()]
+                .iter()
+                .zip(&self.summing_in[range.clone()])
+                .zip(&self.peak_efficiencies[range.clone()])
+                .zip(&self.intensities[range])
+                .map(|(((&out, &sum_in), &peak), &intensity)| {
+                    let peak_rate = intensity * peak;
+                    if peak_rate == 0.0 {
+                        1.0
+                    } else {
+                        out + sum_in / peak_rate
+                    }
+                })
+                .collect(),
+        )
+    }
+
+    /// Computes summing corrections for every $\gamma$ line of the `mixture` at `time`
+    ///
+    /// Lines of nuclides absent from the underlying [`CoincidenceTable`] are not reported
+    pub fn corrections(
+        &self,
+        mixture: &NuclideMixture<'l>,
+        time: f64,
+    ) -> Vec<SummingCorrection<'l>> {
+        let mut tmp = core::mem::MaybeUninit::uninit();
+        let activities = mixture.activities_local(&mut tmp, time);
+        self.corrections_for(
+            activities
+                .iter()
+                .map(|&NuclideActivityPair { nuclide, activity }| (nuclide, activity)),
+        )
+    }
+
+    /// Same as [`SummingCorrections::corrections`], but accepts nuclide activities directly
+    pub fn corrections_for(
+        &self,
+        activities: impl IntoIterator<Item = (&'l Nuclide<'l>, f64)>,
+    ) -> Vec<SummingCorrection<'l>> {
+        let mut res = Vec::new();
+        for (nuclide, activity) in activities {
+            let Some(index) = self.table.position(nuclide) else {
+                continue;
+            };
+            let range = self.offsets[index]..self.offsets[index + 1];
+            let lines = self.table.nuclides[index].lines();
+            res.extend(
+                lines
+                    .iter()
+                    .zip(&self.peak_efficiencies[range.clone()])
+                    .zip(&self.summing_out[range.clone()])
+                    .zip(&self.summing_in[range])
+                    .map(|(((line, &peak), &out), &sum_in)| {
+                        let rate = activity * line.intensity;
+                        let peak_rate = rate * peak;
+                        SummingCorrection {
+                            nuclide,
+                            energy: line.energy,
+                            rate,
+                            peak_rate,
+                            summing_out_rate: peak_rate * (1.0 - out),
+                            summing_in_rate: activity * sum_in,
+                        }
+                    }),
+            );
+        }
+        res
+    }
+}
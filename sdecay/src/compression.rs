@@ -0,0 +1,426 @@
+//! Compressed database input
+//!
+//! Database files compress well (about 10:1 for the full database), so shipping them compressed saves image size and read time on slow storage. Compression format is detected by magic bytes; gzip and zstd are recognized.
+//!
+//! [`CompressedLoader`] decodes data with decoder functions, that stream decompressed data from a reader into a writer. With `gzip` and `zstd` features, decoders based on `flate2` and `zstd` crates are registered by default:
+//! ```rust,ignore
+//! let database: SharedDatabase = CompressedLoader::new().load_path("sandia.decay.xml.zst")?;
+//! ```
+//! Otherwise (or to use a different implementation) any streaming decoder fits:
+//! ```rust,ignore
+//! let loader = CompressedLoader::empty()
+//!     .with_gzip(|input, out| io::copy(&mut flate2::read::MultiGzDecoder::new(input), out).map(drop))
+//!     .with_zstd(|input, out| zstd::stream::copy_decode(input, out));
+//! ```
+//!
+//! Compressed input is never read into memory as a whole, and decompressed data is never copied: the file is streamed through the decoder directly into `SandiaDecay`'s own data vector, which is then parsed in place. The vector is pre-sized from decompressed length stored in the stream (when available), so it is not reallocated along the way. Uncompressed files are passed to `SandiaDecay` by path, as usual.
+//!
+//! With `zstd` feature, embedded databases (see `database*` features) are stored compressed as well, and decoded the same way on initialization.
+//!
+//! Unsafe: no
+
+use core::{mem::MaybeUninit, pin::Pin};
+use std::{
+    borrow::Cow,
+    fs::File,
+    io::{self, BufRead, BufReader, Read, Seek, SeekFrom, Write},
+    path::Path,
+};
+
+use crate::{
+    container::{Container, ExclusiveContainer, RefContainer},
+    database::{GenericDatabase, GenericUninitDatabase},
+    wrapper::{CppException, SandiaDecayDataBase, VecChar},
+};
+
+/// Upper limit on buffer size reserved from decompressed length stored in the stream, guarding against corrupted headers
+///
+/// Larger databases still load, just with a few reallocations
+const MAX_RESERVE: usize = 1 << 30;
+
+/// Longest Zstandard frame header, enough to read decompressed length from
+const ZSTD_HEADER: usize = Compression::ZSTD_MAGIC.len() + 1 + 1 + 4 + 8;
+
+/// Compression format of the database data
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Compression {
+    /// Uncompressed data
+    None,
+    /// gzip stream ([RFC 1952](https://www.rfc-editor.org/rfc/rfc1952))
+    Gzip,
+    /// Zstandard frame ([RFC 8878](https://www.rfc-editor.org/rfc/rfc8878))
+    Zstd,
+}
+
+impl Compression {
+    /// Magic bytes of gzip stream
+    pub const GZIP_MAGIC: [u8; 2] = [0x1f, 0x8b];
+    /// Magic bytes of Zstandard frame
+    pub const ZSTD_MAGIC: [u8; 4] = [0x28, 0xb5, 0x2f, 0xfd];
+
+    /// Detects compression format by the first bytes of data
+    ///
+    /// Anything not starting with a known magic is considered uncompressed
+    pub fn detect(header: &[u8]) -> Self {
+        if header.starts_with(&Self::GZIP_MAGIC) {
+            Self::Gzip
+        } else if header.starts_with(&Self::ZSTD_MAGIC) {
+            Self::Zstd
+        } else {
+            Self::None
+        }
+    }
+}
+
+/// Error while loading compressed database
+#[derive(Debug, Error)]
+pub enum CompressedInitError {
+    /// Failed to read or decompress the data
+    #[error("Failed to read database: {0}")]
+    Io(#[from] io::Error),
+    /// Data is compressed, but no decoder was provided for this format
+    #[error("No decoder for {0:?} compressed database")]
+    NoDecoder(Compression),
+    /// Exception thrown from C++ side while initializing the database
+    #[error(transparent)]
+    Exception(CppException),
+}
+
+/// Streaming decoder: reads compressed data from the reader, and writes decompressed data to the writer
+pub type Decoder = dyn Fn(&mut dyn Read, &mut dyn Write) -> io::Result<()> + Send + Sync;
+
+/// Loader of (possibly) compressed databases, see [module-level docs](self)
+pub struct CompressedLoader {
+    gzip: Option<Box<Decoder>>,
+    zstd: Option<Box<Decoder>>,
+}
+
+impl core::fmt::Debug for CompressedLoader {
+    fn fmt(&self, f: &mut core::fmt::Formatter<'_>) -> core::fmt::Result {
+        f.debug_struct("CompressedLoader")
+            .field("gzip", &self.gzip.is_some())
+            .field("zstd", &self.zstd.is_some())
+            .finish()
+    }
+}
+
+impl Default for CompressedLoader {
+    #[inline]
+    fn default() -> Self {
+        let loader = Self::empty();
+        #[cfg(feature = "gzip")]
+        let loader = loader.with_gzip(decode_gzip);
+        #[cfg(feature = "zstd")]
+        let loader = loader.with_zstd(decode_zstd);
+        loader
+    }
+}
+
+impl CompressedLoader {
+    /// Creates loader with decoders enabled by `gzip` and `zstd` features
+    ///
+    /// With neither of the features, it only accepts uncompressed data
+    #[inline]
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Creates loader with no decoders; it only accepts uncompressed data
+    #[inline]
+    pub fn empty() -> Self {
+        Self {
+            gzip: None,
+            zstd: None,
+        }
+    }
+
+    /// Sets gzip decoder, replacing the default one
+    #[must_use]
+    pub fn with_gzip(
+        mut self,
+        decoder: impl Fn(&mut dyn Read, &mut dyn Write) -> io::Result<()> + Send + Sync + 'static,
+    ) -> Self {
+        self.gzip = Some(Box::new(decoder));
+        self
+    }
+
+    /// Sets Zstandard decoder, replacing the default one
+    #[must_use]
+    pub fn with_zstd(
+        mut self,
+        decoder: impl Fn(&mut dyn Read, &mut dyn Write) -> io::Result<()> + Send + Sync + 'static,
+    ) -> Self {
+        self.zstd = Some(Box::new(decoder));
+        self
+    }
+
+    /// Checks if data compressed with `compression` can be loaded
+    #[inline]
+    pub fn supports(&self, compression: Compression) -> bool {
+        self.decoder(compression).is_ok()
+    }
+
+    /// Decompresses database `bytes`
+    ///
+    /// Uncompressed data is returned as-is, with no copy. Decompressed data is null-terminated, as `SandiaDecay` requires
+    ///
+    /// ### Errors
+    /// - [`CompressedInitError::NoDecoder`], if data is compressed with unsupported format
+    /// - [`CompressedInitError::Io`], if decoder failed
+    pub fn decompress_bytes<'b>(
+        &self,
+        bytes: &'b [u8],
+    ) -> Result<Cow<'b, [u8]>, CompressedInitError> {
+        let compression = Compression::detect(bytes);
+        if compression == Compression::None {
+            return Ok(Cow::Borrowed(bytes));
+        }
+        let decoder = self.decoder(compression)?;
+        let mut out = Vec::with_capacity(reserve(
+            stored_size(compression, bytes),
+            bytes.len().saturating_mul(8),
+        ));
+        decoder(&mut &*bytes, &mut out)?;
+        out.push(0);
+        Ok(Cow::Owned(out))
+    }
+
+    /// Decompresses database, streamed from the `reader`
+    ///
+    /// Unlike [`CompressedLoader::decompress_bytes`], uncompressed data is copied as well. Data is null-terminated
+    ///
+    /// ### Errors
+    /// See [`CompressedLoader::decompress_bytes`]
+    pub fn decompress_reader(&self, reader: impl Read) -> Result<Vec<u8>, CompressedInitError> {
+        let mut reader = BufReader::new(reader);
+        // peek at the header without consuming it
+        let header = reader.fill_buf()?;
+        let compression = Compression::detect(header);
+        let size = match compression {
+            // gzip stores the size at the end
+            Compression::Zstd => zstd_content_size(header),
+            _ => None,
+        };
+        let mut out = Vec::with_capacity(reserve(size, 0));
+        match compression {
+            Compression::None => {
+                reader.read_to_end(&mut out)?;
+            }
+            _ => self.decoder(compression)?(&mut reader, &mut out)?,
+        }
+        out.push(0);
+        Ok(out)
+    }
+
+    /// Decompresses database file at `path`
+    ///
+    /// ### Errors
+    /// See [`CompressedLoader::decompress_bytes`]
+    pub fn decompress_path(&self, path: impl AsRef<Path>) -> Result<Vec<u8>, CompressedInitError> {
+        self.decompress_reader(File::open(path)?)
+    }
+
+    /// Initializes `database` from `bytes`, decompressing them if needed
+    ///
+    /// Data is decompressed straight into `SandiaDecay` vector, see [module-level docs](self). Uncompressed data is copied into it, same as with [`GenericUninitDatabase::init_bytes`]
+    ///
+    /// ### Errors
+    /// See [`CompressedInitError`] variants
+    pub fn init_bytes<C: Container<Inner = SandiaDecayDataBase>>(
+        &self,
+        database: GenericUninitDatabase<C>,
+        bytes: impl AsRef<[u8]>,
+    ) -> Result<GenericDatabase<C>, CompressedInitError> {
+        let bytes = bytes.as_ref();
+        let compression = Compression::detect(bytes);
+        if compression == Compression::None {
+            return database.init_bytes(bytes).map_err(exception);
+        }
+        let capacity = reserve(
+            stored_size(compression, bytes),
+            bytes.len().saturating_mul(8),
+        );
+        self.init_decoded(database, compression, &mut &*bytes, capacity)
+    }
+
+    /// Initializes database from `bytes`, decompressing them if needed
+    ///
+    /// See [`CompressedLoader::init_bytes`]
+    ///
+    /// ### Errors
+    /// See [`CompressedInitError`] variants
+    pub fn load_bytes<C: Container<Inner = SandiaDecayDataBase>>(
+        &self,
+        bytes: impl AsRef<[u8]>,
+    ) -> Result<GenericDatabase<C>, CompressedInitError>
+    where
+        C::Allocator: Default,
+    {
+        self.init_bytes(GenericUninitDatabase::new(), bytes)
+    }
+
+    /// Initializes database from file at `path`, decompressing it if needed
+    ///
+    /// Uncompressed files are read by `SandiaDecay` directly. Compressed files are decompressed straight into `SandiaDecay` vector, see [module-level docs](self)
+    ///
+    /// ### Errors
+    /// See [`CompressedInitError`] variants
+    pub fn load_path<C: Container<Inner = SandiaDecayDataBase>>(
+        &self,
+        path: impl AsRef<Path>,
+    ) -> Result<GenericDatabase<C>, CompressedInitError>
+    where
+        C::Allocator: Default,
+    {
+        let path = path.as_ref();
+        let mut header = [0; ZSTD_HEADER];
+        let mut file = File::open(path)?;
+        let read = read_prefix(&mut file, &mut header)?;
+        let header = &header[..read];
+        let compression = Compression::detect(header);
+        let size = match compression {
+            Compression::None => {
+                drop(file);
+                return GenericDatabase::from_path(path).map_err(CompressedInitError::Exception);
+            }
+            Compression::Gzip => gzip_file_size(&mut file)?,
+            Compression::Zstd => zstd_content_size(header),
+        };
+        // chain the header back, instead of seeking: works with pipes and special files too
+        let mut input = BufReader::new(header.chain(file));
+        self.init_decoded(
+            GenericUninitDatabase::new(),
+            compression,
+            &mut input,
+            reserve(size, 0),
+        )
+    }
+
+    /// Streams decompressed `input` into `SandiaDecay` vector with `capacity` reserved, and initializes `database` from it
+    fn init_decoded<C: Container<Inner = SandiaDecayDataBase>>(
+        &self,
+        database: GenericUninitDatabase<C>,
+        compression: Compression,
+        input: &mut dyn Read,
+        capacity: usize,
+    ) -> Result<GenericDatabase<C>, CompressedInitError> {
+        let decoder = self.decoder(compression)?;
+        let mut tmp = MaybeUninit::uninit();
+        let mut data = VecChar::new_reserve_in::<RefContainer<'_, _>>(&mut tmp, capacity);
+        decoder(input, &mut VecWriter(data.inner()))?;
+        // null terminator is pushed by `init_vec`, into the reserved space
+        database.init_vec(data.inner()).map_err(exception)
+    }
+
+    fn decoder(&self, compression: Compression) -> Result<&Decoder, CompressedInitError> {
+        match compression {
+            Compression::None => None,
+            Compression::Gzip => self.gzip.as_deref(),
+            Compression::Zstd => self.zstd.as_deref(),
+        }
+        .ok_or(CompressedInitError::NoDecoder(compression))
+    }
+}
+
+/// Writer, appending data to C++ vector
+struct VecWriter<'v>(Pin<&'v mut VecChar>);
+
+impl Write for VecWriter<'_> {
+    #[inline]
+    fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
+        self.0.as_mut().extend_from_slice(buf);
+        Ok(buf.len())
+    }
+
+    #[inline]
+    fn flush(&mut self) -> io::Result<()> {
+        Ok(())
+    }
+}
+
+fn exception<D>((_, exception): (D, CppException)) -> CompressedInitError {
+    CompressedInitError::Exception(exception)
+}
+
+#[cfg(feature = "gzip")]
+fn decode_gzip(input: &mut dyn Read, out: &mut dyn Write) -> io::Result<()> {
+    // databases may be concatenated from several members
+    io::copy(&mut flate2::read::MultiGzDecoder::new(input), out).map(drop)
+}
+
+#[cfg(feature = "zstd")]
+fn decode_zstd(input: &mut dyn Read, out: &mut dyn Write) -> io::Result<()> {
+    zstd::stream::copy_decode(input, out)
+}
+
+/// Buffer size to reserve for decompressed data of stored `size` (if known) and null terminator
+fn reserve(size: Option<usize>, fallback: usize) -> usize {
+    size.map_or(fallback, |size| size.saturating_add(1))
+        .min(MAX_RESERVE)
+}
+
+/// Decompressed size stored in whole compressed data
+fn stored_size(compression: Compression, data: &[u8]) -> Option<usize> {
+    match compression {
+        Compression::None => None,
+        Compression::Gzip => gzip_size(data),
+        Compression::Zstd => zstd_content_size(data),
+    }
+}
+
+/// Reads as much of `buffer` as available, stopping at the end of input
+fn read_prefix(reader: &mut impl Read, buffer: &mut [u8]) -> io::Result<usize> {
+    let mut read = 0;
+    while read < buffer.len() {
+        match reader.read(&mut buffer[read..]) {
+            Ok(0) => break,
+            Ok(n) => read += n,
+            Err(error) if error.kind() == io::ErrorKind::Interrupted => {}
+            Err(error) => return Err(error),
+        }
+    }
+    Ok(read)
+}
+
+/// Decompressed size of gzip `file`, read from it's trailer; position in the file is preserved
+///
+/// Size is not known for files that can not seek (like pipes)
+fn gzip_file_size(file: &mut File) -> io::Result<Option<usize>> {
+    let Ok(position) = file.stream_position() else {
+        return Ok(None);
+    };
+    if file.seek(SeekFrom::End(-4)).is_err() {
+        return Ok(None);
+    }
+    let mut trailer = [0; 4];
+    let read = read_prefix(file, &mut trailer)?;
+    file.seek(SeekFrom::Start(position))?;
+    Ok(gzip_size(&trailer[..read]))
+}
+
+/// Decompressed size of a single-member gzip stream (or the last member of multi-member one), stored modulo $2^{32}$ in it's last 4 bytes
+pub(crate) fn gzip_size(stream: &[u8]) -> Option<usize> {
+    let trailer = stream.len().checked_sub(4).map(|start| &stream[start..])?;
+    let size = u32::from_le_bytes(trailer.try_into().ok()?);
+    usize::try_from(size).ok()
+}
+
+/// Decompressed size of Zstandard frame, if stored in the frame header
+pub(crate) fn zstd_content_size(frame: &[u8]) -> Option<usize> {
+    let descriptor = *frame.get(Compression::ZSTD_MAGIC.len())?;
+    let single_segment = descriptor & 0x20 != 0;
+    let size_bytes = match descriptor >> 6 {
+        0 if single_segment => 1,
+        0 => return None,
+        1 => 2,
+        2 => 4,
+        _ => 8,
+    };
+    let dictionary_bytes = [0, 1, 2, 4][usize::from(descriptor & 0x03)];
+    let start = Compression::ZSTD_MAGIC.len() + 1 + usize::from(!single_segment) + dictionary_bytes;
+    let field = frame.get(start..start + size_bytes)?;
+    let mut bytes = [0; 8];
+    bytes[..size_bytes].copy_from_slice(field);
+    let size = u64::from_le_bytes(bytes) + if size_bytes == 2 { 256 } else { 0 };
+    usize::try_from(size).ok()
+}
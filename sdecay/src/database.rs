@@ -7,7 +7,7 @@ use core::{fmt::Debug, ops::Deref, pin::Pin};
 use crate::{
     as_cpp_string::AsCppString,
     container::{Container, RefContainer},
-    wrapper::{CppException, SandiaDecayDataBase},
+    wrapper::{CppException, SandiaDecayDataBase, VecChar},
 };
 
 /// `SandiaDecay`'s database with no info actually stored. Technically, it's already initialized, but I assume none of the calls would return meaningful info (so none are exposed)
@@ -131,6 +131,22 @@ impl<C: Container<Inner = SandiaDecayDataBase>> GenericUninitDatabase<C> {
             Err(exception) => Err((self, exception)),
         }
     }
+
+    /// Attempts to initialize the database via `xml` data already stored in C++ vector
+    ///
+    /// Unlike [`GenericUninitDatabase::init_bytes`], data is not copied. Null terminator is pushed to the vector, unless it's present already; `SandiaDecay` parses data in place, so vector contents are unspecified afterwards
+    ///
+    /// ### Returns
+    /// See [`GenericUninitDatabase::init_bytes`]
+    pub fn init_vec(
+        mut self,
+        bytes: Pin<&mut VecChar>,
+    ) -> Result<GenericDatabase<C>, (GenericUninitDatabase<C>, CppException)> {
+        match self.get_mut().init_vec(bytes) {
+            Ok(()) => Ok(GenericDatabase(self.0)),
+            Err(exception) => Err((self, exception)),
+        }
+    }
 }
 
 /// Error while initializing database by path from environment variable
@@ -186,6 +202,11 @@ impl<C: Container<Inner = SandiaDecayDataBase>> GenericUninitDatabase<C> {
     #[cfg(feature = "database")]
     #[inline]
     pub fn init_vendor(self) -> GenericDatabase<C> {
+        #[cfg(feature = "zstd")]
+        return crate::compression::CompressedLoader::new()
+            .init_bytes(self, sdecay_sys::database::DATABASE_ZST)
+            .expect("Embedded database should be valid");
+        #[cfg(not(feature = "zstd"))]
         self.init_bytes(sdecay_sys::database::DATABASE)
             .expect("Embedded database should be valid")
     }
@@ -203,6 +224,11 @@ impl<C: Container<Inner = SandiaDecayDataBase>> GenericUninitDatabase<C> {
     #[cfg(feature = "database-min")]
     #[inline]
     pub fn init_vendor_min(self) -> GenericDatabase<C> {
+        #[cfg(feature = "zstd")]
+        return crate::compression::CompressedLoader::new()
+            .init_bytes(self, sdecay_sys::database::DATABASE_MIN_ZST)
+            .expect("Embedded database should be valid");
+        #[cfg(not(feature = "zstd"))]
         self.init_bytes(sdecay_sys::database::DATABASE_MIN)
             .expect("Embedded database should be valid")
     }
@@ -220,6 +246,11 @@ impl<C: Container<Inner = SandiaDecayDataBase>> GenericUninitDatabase<C> {
     #[cfg(feature = "database-nocoinc-min")]
     #[inline]
     pub fn init_vendor_nocoinc_min(self) -> GenericDatabase<C> {
+        #[cfg(feature = "zstd")]
+        return crate::compression::CompressedLoader::new()
+            .init_bytes(self, sdecay_sys::database::DATABASE_NOCOINC_MIN_ZST)
+            .expect("Embedded database should be valid");
+        #[cfg(not(feature = "zstd"))]
         self.init_bytes(sdecay_sys::database::DATABASE_NOCOINC_MIN)
             .expect("Embedded database should be valid")
     }
@@ -0,0 +1,292 @@
+//! Decay heat (emitted power) and deposited energy, broken down by radiation class
+//!
+//! [`DecayHeatTable`] holds mean energy emitted per decay of each nuclide, for each [`RadiationClass`], computed once from [`RadParticle`](crate::wrapper::RadParticle) data. Decay heat of a mixture is then a dot product of it's nuclide activities with this table.
+//!
+//! Energies are in `SandiaDecay` units (see [`crate::cst`]), so decay heat is in keV per second; multiply by $1.602\,176\,634 \cdot 10^{-16}$ to get watts.
+//!
+//! Unsafe: no
+
+use alloc::vec::Vec;
+use core::ops::{Add, AddAssign, Index, IndexMut, Mul};
+
+use crate::{
+    lines::{ANNIHILATION_ENERGY, nuclide_key},
+    wrapper::{Nuclide, NuclideActivityPair, NuclideMixture, ProductTypeD, SandiaDecayDataBase},
+};
+
+/// Class of emitted radiation
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum RadiationClass {
+    /// $\alpha$ particles
+    Alpha,
+    /// $e^{-}$ (mean energy, see [`DecayHeatTable::with_beta_fraction`])
+    Beta,
+    /// $e^{+}$ kinetic energy (mean energy, see [`DecayHeatTable::with_beta_fraction`])
+    Positron,
+    /// Annihilation photons of emitted positrons
+    Annihilation,
+    /// $\gamma$ photons
+    Gamma,
+    /// X-ray photons
+    Xray,
+}
+
+impl RadiationClass {
+    /// All the classes, in order of [`DecayHeat::classes`]
+    pub const ALL: [Self; 6] = [
+        Self::Alpha,
+        Self::Beta,
+        Self::Positron,
+        Self::Annihilation,
+        Self::Gamma,
+        Self::Xray,
+    ];
+}
+
+/// Energy (or power) broken down by [`RadiationClass`]
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct DecayHeat {
+    /// Values ordered as in [`RadiationClass::ALL`]
+    pub classes: [f64; 6],
+}
+
+impl DecayHeat {
+    /// Sum over all the classes
+    #[inline]
+    pub fn total(&self) -> f64 {
+        self.classes.iter().sum()
+    }
+
+    /// Sum over photon classes ($\gamma$, x-ray and annihilation)
+    #[inline]
+    pub fn photons(&self) -> f64 {
+        self[RadiationClass::Gamma]
+            + self[RadiationClass::Xray]
+            + self[RadiationClass::Annihilation]
+    }
+
+    /// Sum over charged particle classes ($\alpha$, $e^{-}$ and $e^{+}$), usually deposited locally
+    #[inline]
+    pub fn charged(&self) -> f64 {
+        self[RadiationClass::Alpha] + self[RadiationClass::Beta] + self[RadiationClass::Positron]
+    }
+}
+
+impl Index<RadiationClass> for DecayHeat {
+    type Output = f64;
+
+    #[inline]
+    fn index(&self, class: RadiationClass) -> &f64 {
+        &self.classes[class as usize]
+    }
+}
+
+impl IndexMut<RadiationClass> for DecayHeat {
+    #[inline]
+    fn index_mut(&mut self, class: RadiationClass) -> &mut f64 {
+        &mut self.classes[class as usize]
+    }
+}
+
+impl Add for DecayHeat {
+    type Output = Self;
+
+    #[inline]
+    fn add(mut self, rhs: Self) -> Self {
+        self += rhs;
+        self
+    }
+}
+
+impl AddAssign for DecayHeat {
+    #[inline]
+    fn add_assign(&mut self, rhs: Self) {
+        for (a, b) in self.classes.iter_mut().zip(rhs.classes) {
+            *a += b;
+        }
+    }
+}
+
+impl Mul<f64> for DecayHeat {
+    type Output = Self;
+
+    #[inline]
+    fn mul(mut self, rhs: f64) -> Self {
+        self.classes.iter_mut().for_each(|value| *value *= rhs);
+        self
+    }
+}
+
+/// Mean emitted energy per decay of each nuclide, see [module-level docs](self)
+#[derive(Debug, Clone)]
+pub struct DecayHeatTable<'l> {
+    // sorted by address, to allow binary search
+    nuclides: Vec<&'l Nuclide<'l>>,
+    energies: Vec<DecayHeat>,
+}
+
+impl<'l> DecayHeatTable<'l> {
+    /// Fraction of $\beta$ endpoint energy used as mean energy by [`DecayHeatTable::new`]
+    pub const DEFAULT_BETA_FRACTION: f64 = 1.0 / 3.0;
+
+    /// Builds table for every nuclide in the database
+    ///
+    /// `SandiaDecay` stores endpoint energies of $\beta^{\pm}$ spectra; mean energy is taken to be [`DecayHeatTable::DEFAULT_BETA_FRACTION`] of it
+    pub fn new(database: &'l SandiaDecayDataBase) -> Self {
+        Self::with_beta_fraction(database, Self::DEFAULT_BETA_FRACTION)
+    }
+
+    /// Same as [`DecayHeatTable::new`], but with custom ratio of mean to endpoint $\beta^{\pm}$ energy
+    pub fn with_beta_fraction(database: &'l SandiaDecayDataBase, beta_fraction: f64) -> Self {
+        Self::from_nuclides(database.nuclides().iter().copied(), beta_fraction)
+    }
+
+    /// Builds table for specified nuclides only, duplicates are ignored
+    pub fn from_nuclides(
+        nuclides: impl IntoIterator<Item = &'l Nuclide<'l>>,
+        beta_fraction: f64,
+    ) -> Self {
+        let mut nuclides = nuclides.into_iter().collect::<Vec<_>>();
+        nuclides.sort_unstable_by_key(|nuclide| nuclide_key(nuclide));
+        nuclides.dedup_by_key(|nuclide| nuclide_key(nuclide));
+        let energies = nuclides
+            .iter()
+            .map(|nuclide| mean_energies(nuclide, beta_fraction))
+            .collect();
+        Self { nuclides, energies }
+    }
+
+    /// Nuclides in the table
+    #[inline]
+    pub fn nuclides(&self) -> &[&'l Nuclide<'l>] {
+        &self.nuclides
+    }
+
+    /// Position of the `nuclide` in [`DecayHeatTable::nuclides`]
+    pub fn position(&self, nuclide: &Nuclide<'_>) -> Option<usize> {
+        let key = nuclide_key(nuclide);
+        self.nuclides
+            .binary_search_by_key(&key, |nuclide| nuclide_key(nuclide))
+            .ok()
+    }
+
+    /// Mean energy emitted per decay of the `nuclide`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide is not in the table
+    #[inline]
+    pub fn energy_per_decay(&self, nuclide: &Nuclide<'_>) -> Option<DecayHeat> {
+        self.position(nuclide)
+            .map(|position| self.energies[position])
+    }
+
+    /// Emitted power, given nuclide `activities`
+    ///
+    /// Nuclides absent from the table are ignored. Passing numbers of decays instead of activities yields emitted energy
+    pub fn power_for<'n>(
+        &self,
+        activities: impl IntoIterator<Item = (&'n Nuclide<'n>, f64)>,
+    ) -> DecayHeat {
+        let mut heat = DecayHeat::default();
+        for (nuclide, activity) in activities {
+            if activity == 0.0 {
+                continue;
+            }
+            if let Some(position) = self.position(nuclide) {
+                heat += self.energies[position] * activity;
+            }
+        }
+        heat
+    }
+
+    /// Power emitted by `mixture` at `time`
+    pub fn power(&self, mixture: &NuclideMixture<'_>, time: f64) -> DecayHeat {
+        let mut tmp = core::mem::MaybeUninit::uninit();
+        let activities = mixture.activities_local(&mut tmp, time);
+        self.power_for(
+            activities
+                .as_slice()
+                .iter()
+                .map(|&NuclideActivityPair { nuclide, activity }| (nuclide, activity)),
+        )
+    }
+
+    /// Decay heat curve of `mixture`: power emitted at each of `times`
+    ///
+    /// Nuclide positions are resolved once; activities at each time are evaluated from mixture's evolution terms
+    #[cfg(feature = "std")]
+    pub fn power_curve(&self, mixture: &NuclideMixture<'_>, times: &[f64]) -> Vec<DecayHeat> {
+        let evolutions = self.resolve(mixture);
+        times
+            .iter()
+            .map(|&time| {
+                let mut heat = DecayHeat::default();
+                for &(evolution, energies) in &evolutions {
+                    heat += energies * evolution.activity(time);
+                }
+                heat
+            })
+            .collect()
+    }
+
+    /// Energy deposition curve of `mixture`: energy emitted over each time interval $[t_i; t_{i+1}]$ between consecutive `times`
+    ///
+    /// Numbers of decays are integrated analytically (see [`NuclideTimeEvolution::num_decays`](crate::wrapper::NuclideTimeEvolution::num_decays)); result has one element less than `times`
+    #[cfg(feature = "std")]
+    pub fn energy_curve(&self, mixture: &NuclideMixture<'_>, times: &[f64]) -> Vec<DecayHeat> {
+        let evolutions = self.resolve(mixture);
+        times
+            .windows(2)
+            .map(|interval| {
+                let mut heat = DecayHeat::default();
+                for &(evolution, energies) in &evolutions {
+                    heat += energies * evolution.num_decays(interval[0], interval[1]);
+                }
+                heat
+            })
+            .collect()
+    }
+
+    /// Pairs mixture's evolutions with energies per decay, dropping nuclides emitting nothing
+    #[cfg(feature = "std")]
+    fn resolve<'m, 'n>(
+        &self,
+        mixture: &'m NuclideMixture<'n>,
+    ) -> Vec<(&'m crate::wrapper::NuclideTimeEvolution<'n>, DecayHeat)> {
+        mixture
+            .decayed_to_nuclides_evolutions()
+            .iter()
+            .filter_map(|evolution| {
+                let energies = self.energy_per_decay(evolution.nuclide)?;
+                (energies.total() != 0.0).then_some((evolution, energies))
+            })
+            .collect()
+    }
+}
+
+/// Computes mean energy emitted per decay of `nuclide`
+fn mean_energies(nuclide: &Nuclide<'_>, beta_fraction: f64) -> DecayHeat {
+    let mut heat = DecayHeat::default();
+    for transition in &nuclide.decays_to_children {
+        let branch_ratio = f64::from(transition.branch_ratio);
+        for particle in &transition.products {
+            let intensity = branch_ratio * f64::from(particle.intensity);
+            let energy = f64::from(particle.energy);
+            match particle.r#type.d() {
+                ProductTypeD::AlphaParticle => heat[RadiationClass::Alpha] += intensity * energy,
+                ProductTypeD::BetaParticle => {
+                    heat[RadiationClass::Beta] += intensity * energy * beta_fraction;
+                }
+                ProductTypeD::PositronParticle => {
+                    heat[RadiationClass::Positron] += intensity * energy * beta_fraction;
+                    heat[RadiationClass::Annihilation] += intensity * 2.0 * ANNIHILATION_ENERGY;
+                }
+                ProductTypeD::GammaParticle => heat[RadiationClass::Gamma] += intensity * energy,
+                ProductTypeD::XrayParticle => heat[RadiationClass::Xray] += intensity * energy,
+                // neutrinos escape
+                ProductTypeD::CaptureElectronParticle | ProductTypeD::Unknown => {}
+            }
+        }
+    }
+    heat
+}
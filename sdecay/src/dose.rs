@@ -0,0 +1,179 @@
+//! Precomputed dose-rate constants and fast mixture dose-rate evaluation
+//!
+//! [`DoseRateTable`] holds, for each nuclide, a dose-rate constant: dose (times area) per decay,
+//! $$
+//! \Gamma_n = \sum_i I_{n,i} \, h(E_{n,i}) \, w(E_{n,i}),
+//! $$
+//! where $I_{n,i}$ are line intensities, $h$ is a user-supplied fluence-to-dose conversion coefficient and $w$ is an optional attenuation weighting (see `weighting` module, requires `std` feature). Dose rate of an unshielded point source at distance $r$ is then
+//! $$
+//! \dot D = \frac{1}{4 \pi r^2} \sum_n A_n \Gamma_n,
+//! $$
+//! so that mixture evaluation is a single weighted sum over nuclide activities, with no per-line work.
+//!
+//! Units of dose are those of $h$ (e.g. with $h$ in $\text{Sv} \cdot \text{cm}^2$ and distances in [`crate::cst::cm`], dose rate is in Sv per second).
+//!
+//! Unsafe: no
+
+use alloc::vec::Vec;
+
+use crate::{
+    efficiency::EfficiencyCurve,
+    lines::LineIndex,
+    wrapper::{Nuclide, NuclideActivityPair, NuclideMixture},
+};
+
+/// Dose-rate constants of nuclides, see [module-level docs](self)
+#[derive(Debug, Clone)]
+pub struct DoseRateTable<'i, 'l> {
+    lines: &'i LineIndex<'l>,
+    constants: Vec<f64>,
+}
+
+impl<'i, 'l> DoseRateTable<'i, 'l> {
+    /// Builds dose-rate constants for every nuclide in `lines`, with `flux_to_dose` conversion coefficients
+    ///
+    /// Use a [`LineIndex`] of $\gamma$ lines (see [`LineSelection::GAMMAS`](crate::lines::LineSelection::GAMMAS)) for a conventional $\gamma$ dose-rate constant
+    pub fn new(lines: &'i LineIndex<'l>, flux_to_dose: &impl EfficiencyCurve) -> Self {
+        Self::with_attenuation(lines, flux_to_dose, &|_: f64| 1.0)
+    }
+
+    /// Same as [`DoseRateTable::new`], but every line is additionally weighted by `attenuation` (e.g. a shielding layer)
+    pub fn with_attenuation(
+        lines: &'i LineIndex<'l>,
+        flux_to_dose: &impl EfficiencyCurve,
+        attenuation: &impl EfficiencyCurve,
+    ) -> Self {
+        let constants = (0..lines.nuclides().len())
+            .map(|position| {
+                let nuclide_lines = lines.lines_at(position);
+                nuclide_lines
+                    .energies
+                    .iter()
+                    .zip(nuclide_lines.intensities)
+                    .map(|(&energy, &intensity)| {
+                        intensity * flux_to_dose.efficiency(energy) * attenuation.efficiency(energy)
+                    })
+                    .sum()
+            })
+            .collect();
+        Self { lines, constants }
+    }
+
+    /// Nuclides in the table, in order of [`DoseRateTable::constants`]
+    #[inline]
+    pub fn nuclides(&self) -> &[&'l Nuclide<'l>] {
+        self.lines.nuclides()
+    }
+
+    /// Dose-rate constants, in order of [`DoseRateTable::nuclides`]
+    #[inline]
+    pub fn constants(&self) -> &[f64] {
+        &self.constants
+    }
+
+    /// Dose-rate constant of the `nuclide`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide is not in the table
+    #[inline]
+    pub fn constant(&self, nuclide: &Nuclide<'_>) -> Option<f64> {
+        self.lines
+            .position(nuclide)
+            .map(|position| self.constants[position])
+    }
+
+    /// Source strength $\sum_n A_n \Gamma_n$, given nuclide `activities`
+    ///
+    /// Divide by $4 \pi r^2$ to get dose rate at distance $r$. Nuclides absent from the table are ignored
+    pub fn source_strength_for<'n>(
+        &self,
+        activities: impl IntoIterator<Item = (&'n Nuclide<'n>, f64)>,
+    ) -> f64 {
+        activities
+            .into_iter()
+            .filter_map(|(nuclide, activity)| Some(activity * self.constant(nuclide)?))
+            .sum()
+    }
+
+    /// Source strength of `mixture` at `time`, see [`DoseRateTable::source_strength_for`]
+    pub fn source_strength(&self, mixture: &NuclideMixture<'_>, time: f64) -> f64 {
+        let mut tmp = core::mem::MaybeUninit::uninit();
+        let activities = mixture.activities_local(&mut tmp, time);
+        self.source_strength_for(
+            activities
+                .as_slice()
+                .iter()
+                .map(|&NuclideActivityPair { nuclide, activity }| (nuclide, activity)),
+        )
+    }
+
+    /// Dose rate of `mixture` at `time`, as an unshielded point source at `distance`
+    #[inline]
+    pub fn dose_rate(&self, mixture: &NuclideMixture<'_>, time: f64, distance: f64) -> f64 {
+        self.source_strength(mixture, time) / (4.0 * core::f64::consts::PI * distance * distance)
+    }
+
+    /// Computes source strengths for every row of (sources × nuclides) `activities` matrix (nuclides ordered as in [`DoseRateTable::nuclides`]), writing them into `out`
+    ///
+    /// This is a dense matrix-vector product, with no nuclide lookups
+    ///
+    /// ### Panics
+    /// If `activities` length is not `out` length times number of nuclides
+    pub fn source_strengths_into(&self, activities: &[f64], out: &mut [f64]) {
+        let nuclides = self.constants.len();
+        assert_eq!(
+            activities.len(),
+            out.len() * nuclides,
+            "activities should match output and nuclides"
+        );
+        if nuclides == 0 {
+            out.fill(0.0);
+            return;
+        }
+        for (row, out) in activities.chunks_exact(nuclides).zip(out) {
+            *out = row.iter().zip(&self.constants).map(|(a, g)| a * g).sum();
+        }
+    }
+
+    /// Same as [`DoseRateTable::source_strengths_into`], but splits rows between `threads` threads
+    #[cfg(feature = "std")]
+    pub fn source_strengths_parallel(&self, activities: &[f64], threads: usize) -> Vec<f64> {
+        let nuclides = self.constants.len();
+        let rows = activities.len().checked_div(nuclides).unwrap_or(0);
+        let mut out = alloc::vec![0.0; rows];
+        if rows == 0 {
+            return out;
+        }
+        crate::parallel::for_each_mut(&mut out, 1, threads, |rows, out| {
+            self.source_strengths_into(
+                &activities[rows.start * nuclides..rows.end * nuclides],
+                out,
+            );
+        });
+        out
+    }
+
+    /// Source strength of `mixture` at each of `times`
+    ///
+    /// Nuclide positions are resolved once; activities at each time are evaluated from mixture's evolution terms
+    #[cfg(feature = "std")]
+    pub fn source_strength_curve(&self, mixture: &NuclideMixture<'_>, times: &[f64]) -> Vec<f64> {
+        let evolutions = mixture
+            .decayed_to_nuclides_evolutions()
+            .iter()
+            .filter_map(|evolution| {
+                let constant = self.constant(evolution.nuclide)?;
+                (constant != 0.0).then_some((evolution, constant))
+            })
+            .collect::<Vec<_>>();
+        times
+            .iter()
+            .map(|&time| {
+                evolutions
+                    .iter()
+                    .map(|(evolution, constant)| evolution.activity(time) * constant)
+                    .sum()
+            })
+            .collect()
+    }
+}
@@ -0,0 +1,22 @@
+//! Energy-dependent weightings of emission lines
+//!
+//! [`EfficiencyCurve`] is a single trait for anything that scales a line by a function of it's energy: detector efficiencies (see `coincidence` module), flux-to-dose conversion (see `dose` module), attenuation and line weightings (see `weighting` module, requires `std` feature).
+//!
+//! Unsafe: no
+
+/// Detector efficiency (or any other weighting) as a function of photon energy
+///
+/// Energy is passed in `SandiaDecay` units (see [`crate::cst`]), efficiency is expected to be a fraction ($\in [0; 1]$)
+///
+/// Implemented for any `Fn(f64) -> f64` closure
+pub trait EfficiencyCurve {
+    /// Efficiency at the specified `energy`
+    fn efficiency(&self, energy: f64) -> f64;
+}
+
+impl<F: Fn(f64) -> f64> EfficiencyCurve for F {
+    #[inline]
+    fn efficiency(&self, energy: f64) -> f64 {
+        self(energy)
+    }
+}
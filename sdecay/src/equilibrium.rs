@@ -0,0 +1,320 @@
+//! Automatic prompt-equilibrium folding of short-lived daughters
+//!
+//! Past a few of it's half-lives, a short-lived daughter forgets it's initial amount, and simply follows it's ancestors: it's evolution has the same exponents, just scaled. [`EquilibriumFolding`] solves a mixture for times no earlier than some minimum time of interest $t_{min}$, folding every daughter with half-life well below $t_{min}$ into it's ancestors' equilibrium: terms with it's decay constant as the exponent (it's own transient $C e^{-\lambda t}$, and the terms it induces in descendants) are negligible by $t_{min}$, and are dropped from evolution tables. For Rn/Po-heavy chains this removes most of the terms from the evolution tables.
+//!
+//! Evolution is propagated along the decay graph in topological order: nuclide fed with $F e^{-k t}$ receives term $\frac{F}{\lambda - k} e^{-k t}$, plus it's own transient, set by the initial amount. Dropped terms still take part in propagation, so initial amounts of descendants stay exact. Folded nuclides remain available in [`FoldedMixture::folded`], so their activities are still obtained by scaling the exponentials of their ancestors.
+//!
+//! `SandiaDecay`'s [`add_nuclide_in_prompt_equilibrium`](crate::nuclide_mixture::GenericMixture::add_nuclide_in_prompt_equilibrium) sets up equilibrium at $t = 0$ instead; here initial amounts are exact, and equilibrium is only assumed for $t \ge t_{min}$.
+//!
+//! Unsafe: no
+
+use alloc::{
+    collections::{BTreeMap, BTreeSet},
+    vec::Vec,
+};
+
+use crate::{lines::nuclide_key, solved::SolvedMixture, wrapper::Nuclide};
+
+/// Relative difference of decay constants, below which propagated solution is considered degenerate
+const DEGENERATE_TOLERANCE: f64 = 1e-9;
+
+/// Configuration of prompt-equilibrium folding, see [module-level docs](self)
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct EquilibriumFolding {
+    min_time: f64,
+    half_lives: f64,
+}
+
+impl EquilibriumFolding {
+    /// Default value of [`EquilibriumFolding::with_half_lives`]: folded transients decay by $2^{-50} \approx 10^{-15}$
+    pub const DEFAULT_HALF_LIVES: f64 = 50.0;
+
+    /// Creates folding configuration for times no earlier than `min_time`
+    ///
+    /// ### Panics
+    /// If `min_time` is negative
+    pub fn new(min_time: f64) -> Self {
+        assert!(min_time >= 0.0, "minimum time should be non-negative");
+        Self {
+            min_time,
+            half_lives: Self::DEFAULT_HALF_LIVES,
+        }
+    }
+
+    /// Sets number of half-lives, that should fit into minimum time for a daughter to be folded
+    ///
+    /// At $t_{min}$, transient of a folded nuclide is suppressed by a factor of at least $2^{-\text{half\_lives}}$
+    ///
+    /// ### Panics
+    /// If `half_lives` is not positive
+    #[must_use]
+    pub fn with_half_lives(mut self, half_lives: f64) -> Self {
+        assert!(half_lives > 0.0, "number of half-lives should be positive");
+        self.half_lives = half_lives;
+        self
+    }
+
+    /// Minimum time of interest
+    #[inline]
+    pub fn min_time(&self) -> f64 {
+        self.min_time
+    }
+
+    /// Checks if non-initial `nuclide` would be folded
+    #[inline]
+    pub fn folds(&self, nuclide: &Nuclide<'_>) -> bool {
+        self.folds_decay_constant(nuclide.decay_constant())
+    }
+
+    #[inline]
+    fn folds_decay_constant(&self, lambda: f64) -> bool {
+        lambda > 0.0 && core::f64::consts::LN_2 / lambda * self.half_lives <= self.min_time
+    }
+
+    /// Solves evolution of mixture with `initial` nuclides and their numbers of atoms, folding short-lived daughters
+    ///
+    /// Initial nuclides are never folded. If propagated solution happens to be degenerate (nuclide fed with exponent, equal to it's own decay constant), mixture is solved by `SandiaDecay` instead, with nothing folded
+    pub fn solve<'l>(&self, initial: &[(&'l Nuclide<'l>, f64)]) -> FoldedMixture<'l> {
+        self.solve_with(initial, &|nuclide| nuclide.decay_constant())
+            .unwrap_or_else(|| {
+                let mut mixture = crate::Mixture::new();
+                for &(nuclide, atoms) in initial {
+                    mixture.add_nuclide_by_abundance(nuclide, atoms);
+                }
+                FoldedMixture {
+                    min_time: self.min_time,
+                    kept: mixture.solve(),
+                    folded: SolvedMixture::from_parts(
+                        Vec::new(),
+                        Vec::new(),
+                        alloc::vec![0],
+                        Vec::new(),
+                        Vec::new(),
+                        Vec::new(),
+                    ),
+                }
+            })
+    }
+
+    /// Propagates evolution, with nuclide decay constants provided by `decay_constant`
+    ///
+    /// ### Returns
+    /// [`Option::None`], if solution is degenerate
+    pub(crate) fn solve_with<'l>(
+        &self,
+        initial: &[(&'l Nuclide<'l>, f64)],
+        decay_constant: &impl Fn(&Nuclide<'_>) -> f64,
+    ) -> Option<FoldedMixture<'l>> {
+        // topological order of all the descendants
+        let mut order = Vec::new();
+        let mut visited = BTreeSet::new();
+        for &(nuclide, _) in initial {
+            visit(nuclide, &mut visited, &mut order);
+        }
+        order.reverse();
+        let positions = order
+            .iter()
+            .enumerate()
+            .map(|(position, nuclide)| (nuclide_key(nuclide), position))
+            .collect::<BTreeMap<_, _>>();
+        let mut initial_atoms = alloc::vec![0.0; order.len()];
+        let mut is_initial = alloc::vec![false; order.len()];
+        for &(nuclide, atoms) in initial {
+            let position = positions[&nuclide_key(nuclide)];
+            initial_atoms[position] += atoms;
+            is_initial[position] = true;
+        }
+
+        // `(exponent, coefficient, is folded)` of feeding rate for each nuclide
+        let mut feeds = alloc::vec![Vec::<(f64, f64, bool)>::new(); order.len()];
+        let mut kept = Rows::default();
+        let mut folded = Rows::default();
+        for (position, &nuclide) in order.iter().enumerate() {
+            let lambda = decay_constant(nuclide);
+            let mut feed = core::mem::take(&mut feeds[position]);
+            merge_terms(&mut feed);
+            let mut terms = Vec::with_capacity(feed.len() + 1);
+            let mut at_zero = 0.0;
+            for (k, f, folded) in feed {
+                let difference = lambda - k;
+                if difference.abs() <= DEGENERATE_TOLERANCE * lambda.max(k) {
+                    return None;
+                }
+                let c = f / difference;
+                at_zero += c;
+                terms.push((k, c, folded));
+            }
+            let fold = !is_initial[position] && self.folds_decay_constant(lambda);
+            let transient = initial_atoms[position] - at_zero;
+            if transient != 0.0 {
+                terms.push((lambda, transient, fold));
+            }
+            for transition in &nuclide.decays_to_children {
+                let Some(child) = transition.child else {
+                    continue;
+                };
+                let rate = f64::from(transition.branch_ratio) * lambda;
+                if rate > 0.0 {
+                    let child = positions[&nuclide_key(child)];
+                    feeds[child].extend(terms.iter().map(|&(k, c, folded)| (k, c * rate, folded)));
+                }
+            }
+            let rows = if fold { &mut folded } else { &mut kept };
+            rows.push(
+                nuclide,
+                lambda,
+                &terms,
+                is_initial[position].then_some(initial_atoms[position]),
+            );
+        }
+        Some(FoldedMixture {
+            min_time: self.min_time,
+            kept: kept.finish(),
+            folded: folded.finish(),
+        })
+    }
+}
+
+/// Depth-first postorder of `nuclide` descendants
+fn visit<'l>(
+    nuclide: &'l Nuclide<'l>,
+    visited: &mut BTreeSet<usize>,
+    order: &mut Vec<&'l Nuclide<'l>>,
+) {
+    if !visited.insert(nuclide_key(nuclide)) {
+        return;
+    }
+    for transition in &nuclide.decays_to_children {
+        if let Some(child) = transition.child {
+            visit(child, visited, order);
+        }
+    }
+    order.push(nuclide);
+}
+
+/// Sorts terms by exponent, combining terms with equal exponents
+///
+/// Combined term is folded only if all of it's parts are
+fn merge_terms(terms: &mut Vec<(f64, f64, bool)>) {
+    terms.sort_by(|(a, ..), (b, ..)| a.total_cmp(b));
+    terms.dedup_by(|(k, c, folded), (kept_k, kept_c, kept_folded)| {
+        let equal = k == kept_k;
+        if equal {
+            *kept_c += *c;
+            *kept_folded &= *folded;
+        }
+        equal
+    });
+}
+
+/// Solution table under construction
+#[derive(Debug, Default)]
+struct Rows<'l> {
+    nuclides: Vec<&'l Nuclide<'l>>,
+    decay_constants: Vec<f64>,
+    term_offsets: Vec<usize>,
+    coefficients: Vec<f64>,
+    exponents: Vec<f64>,
+    initial: Vec<(u32, f64)>,
+}
+
+impl<'l> Rows<'l> {
+    /// Adds nuclide's row, skipping folded terms
+    fn push(
+        &mut self,
+        nuclide: &'l Nuclide<'l>,
+        lambda: f64,
+        terms: &[(f64, f64, bool)],
+        initial: Option<f64>,
+    ) {
+        if let Some(atoms) = initial {
+            self.initial.push((self.nuclides.len() as u32, atoms));
+        }
+        self.nuclides.push(nuclide);
+        self.decay_constants.push(lambda);
+        self.term_offsets.push(self.coefficients.len());
+        for &(k, c, folded) in terms {
+            if folded {
+                continue;
+            }
+            self.exponents.push(k);
+            self.coefficients.push(c);
+        }
+    }
+
+    fn finish(mut self) -> SolvedMixture<'l> {
+        self.term_offsets.push(self.coefficients.len());
+        SolvedMixture::from_parts(
+            self.nuclides,
+            self.decay_constants,
+            self.term_offsets,
+            self.coefficients,
+            self.exponents,
+            self.initial,
+        )
+    }
+}
+
+/// Mixture solved with prompt-equilibrium folding, see [`EquilibriumFolding::solve`]
+///
+/// All the queries are only valid for times no earlier than [`FoldedMixture::min_time`]
+#[derive(Debug, Clone)]
+pub struct FoldedMixture<'l> {
+    min_time: f64,
+    kept: SolvedMixture<'l>,
+    folded: SolvedMixture<'l>,
+}
+
+impl<'l> FoldedMixture<'l> {
+    /// Minimum time of interest, this mixture was solved for
+    #[inline]
+    pub fn min_time(&self) -> f64 {
+        self.min_time
+    }
+
+    /// Nuclides, that were not folded (including all the initial nuclides)
+    #[inline]
+    pub fn kept(&self) -> &SolvedMixture<'l> {
+        &self.kept
+    }
+
+    /// Folded nuclides; their evolutions only contain exponents of their ancestors
+    #[inline]
+    pub fn folded(&self) -> &SolvedMixture<'l> {
+        &self.folded
+    }
+
+    /// Unwraps kept nuclides, discarding folded ones
+    pub(crate) fn into_kept(self) -> SolvedMixture<'l> {
+        self.kept
+    }
+
+    /// Total number of evolution terms
+    #[inline]
+    pub fn num_terms(&self) -> usize {
+        self.kept.num_terms() + self.folded.num_terms()
+    }
+
+    /// Number of atoms of the `nuclide` at `time`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide is not among the descendants of initial nuclides
+    pub fn num_atoms(&self, time: f64, nuclide: &Nuclide<'_>) -> Option<f64> {
+        self.kept
+            .num_atoms(time, nuclide)
+            .or_else(|| self.folded.num_atoms(time, nuclide))
+    }
+
+    /// Activity of the `nuclide` at `time`, see [`FoldedMixture::num_atoms`]
+    pub fn activity(&self, time: f64, nuclide: &Nuclide<'_>) -> Option<f64> {
+        self.kept
+            .activity(time, nuclide)
+            .or_else(|| self.folded.activity(time, nuclide))
+    }
+
+    /// Total activity at `time`
+    #[inline]
+    pub fn total_activity(&self, time: f64) -> f64 {
+        self.kept.total_activity(time) + self.folded.total_activity(time)
+    }
+}
@@ -0,0 +1,304 @@
+//! Monte Carlo generator of individual decay events
+//!
+//! Each event is sampled in three steps, using [`AliasTable`]s and probabilities computed once, at generator construction:
+//! 1. decaying nuclide, weighted by it's activity at the time generator was created for ($O(1)$)
+//! 2. decay [`Transition`], weighted by it's branching ratio ($O(1)$)
+//! 3. emitted [`RadParticle`](crate::wrapper::RadParticle)s
+//!
+//! Particles of a transition are sampled by kind:
+//! - $\beta^{-}$, $\beta^{+}$, $\alpha$ and electron capture entries are alternative branches (e.g. different $\beta$ endpoints), so at most one of them is emitted, chosen with probabilities equal to their intensities ($O(1)$)
+//! - every other particle (photons) is a separate Bernoulli trial with probability of it's intensity; intensity $I > 1$ emits $\lfloor I \rfloor$ copies, and one more with probability $I - \lfloor I \rfloor$ ($O(n)$ in the number of such particles)
+//!
+//! This preserves the mean emission rate of every particle, and never emits the same line twice (unless it's intensity is above 1), but since particle intensities do not describe correlations between particles, cascade correlations are not reproduced.
+//!
+//! Events are written into a flat [`EventBuffer`], which can be reused between batches to avoid allocations.
+//!
+//! Unsafe: no
+
+use alloc::vec::Vec;
+
+use crate::{
+    random::{AliasTable, Rng},
+    wrapper::{
+        Nuclide, NuclideActivityPair, NuclideMixture, ProductType, ProductTypeD, Transition,
+    },
+};
+
+/// A single sampled decay event
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct DecayEvent {
+    /// Index of the decayed nuclide in [`EventGenerator::nuclides`]
+    pub nuclide: u32,
+    /// Index of the transition in [`Nuclide::decays_to_children`]
+    pub transition: u32,
+    /// Index of the first emitted particle in [`EventBuffer::particles`]
+    pub first_particle: u32,
+    /// Number of emitted particles
+    pub num_particles: u32,
+}
+
+/// A particle emitted in a [`DecayEvent`]
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct EmittedParticle {
+    /// Index of the particle in [`Transition::products`]
+    pub product: u32,
+    /// Particle type
+    pub r#type: ProductType,
+    /// Particle energy, in `SandiaDecay` units
+    pub energy: f32,
+}
+
+/// Flat storage of generated events
+#[derive(Debug, Default, Clone)]
+pub struct EventBuffer {
+    /// Generated events
+    pub events: Vec<DecayEvent>,
+    /// Particles of all the generated events, referenced by [`DecayEvent::first_particle`] and [`DecayEvent::num_particles`]
+    pub particles: Vec<EmittedParticle>,
+}
+
+impl EventBuffer {
+    /// Creates empty buffer
+    #[inline]
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Removes all events, keeping allocated memory
+    #[inline]
+    pub fn clear(&mut self) {
+        self.events.clear();
+        self.particles.clear();
+    }
+
+    /// Particles emitted in the `event`
+    ///
+    /// ### Panics
+    /// If `event` does not belong to this buffer
+    #[inline]
+    pub fn particles_of(&self, event: &DecayEvent) -> &[EmittedParticle] {
+        let first = event.first_particle as usize;
+        &self.particles[first..first + event.num_particles as usize]
+    }
+}
+
+/// Particle, emitted independently of others
+#[derive(Debug)]
+struct IndependentParticle {
+    particle: EmittedParticle,
+    /// Integer part of intensity
+    copies: u32,
+    /// Fractional part of intensity
+    extra_probability: f64,
+}
+
+#[derive(Debug)]
+struct TransitionSampler {
+    /// Alternative branches ($\beta$, $\alpha$, etc), weighted by intensities
+    branches: Option<AliasTable>,
+    /// Probability to emit any of the alternative branches
+    branch_probability: f64,
+    branch_products: Vec<EmittedParticle>,
+    independent: Vec<IndependentParticle>,
+}
+
+impl TransitionSampler {
+    fn new(transition: &Transition<'_>) -> Self {
+        let mut branch_products = Vec::new();
+        let mut weights = Vec::new();
+        let mut independent = Vec::new();
+        for (product, particle) in transition.products.as_slice().iter().enumerate() {
+            let emitted = EmittedParticle {
+                product: product as u32,
+                r#type: particle.r#type,
+                energy: particle.energy,
+            };
+            let intensity = f64::from(particle.intensity);
+            if intensity.is_nan() || intensity <= 0.0 {
+                continue;
+            }
+            match particle.r#type.d() {
+                ProductTypeD::BetaParticle
+                | ProductTypeD::PositronParticle
+                | ProductTypeD::AlphaParticle
+                | ProductTypeD::CaptureElectronParticle => {
+                    branch_products.push(emitted);
+                    weights.push(intensity);
+                }
+                _ => {
+                    let copies = intensity as u32;
+                    independent.push(IndependentParticle {
+                        particle: emitted,
+                        copies,
+                        extra_probability: intensity - f64::from(copies),
+                    });
+                }
+            }
+        }
+        let branches = AliasTable::new(&weights);
+        // intensities of alternatives should sum up to at most 1, but data is not always perfect
+        let branch_probability = branches
+            .as_ref()
+            .map_or(0.0, |branches| branches.total_weight().min(1.0));
+        Self {
+            branches,
+            branch_probability,
+            branch_products,
+            independent,
+        }
+    }
+
+    /// Samples particles, appending them to `out`
+    #[inline]
+    fn sample(&self, rng: &mut Rng, out: &mut Vec<EmittedParticle>) {
+        if let Some(branches) = &self.branches
+            && rng.next_f64() < self.branch_probability
+        {
+            out.push(self.branch_products[branches.sample(rng)]);
+        }
+        for independent in &self.independent {
+            let count =
+                independent.copies + u32::from(rng.next_f64() < independent.extra_probability);
+            for _ in 0..count {
+                out.push(independent.particle);
+            }
+        }
+    }
+}
+
+#[derive(Debug)]
+struct NuclideSampler {
+    transitions: Option<AliasTable>,
+    samplers: Vec<TransitionSampler>,
+}
+
+impl NuclideSampler {
+    fn new(nuclide: &Nuclide<'_>) -> Self {
+        let transitions = nuclide.decays_to_children.as_slice();
+        let weights = transitions
+            .iter()
+            .map(|transition| f64::from(transition.branch_ratio))
+            .collect::<Vec<_>>();
+        Self {
+            transitions: AliasTable::new(&weights),
+            samplers: transitions
+                .iter()
+                .map(|transition| TransitionSampler::new(transition))
+                .collect(),
+        }
+    }
+}
+
+/// Generator of decay events for a fixed set of nuclide activities
+///
+/// Generator is immutable once constructed, and can be shared between threads; each thread should use it's own [`Rng`] (see [`Rng::stream`])
+#[derive(Debug)]
+pub struct EventGenerator<'l> {
+    nuclides: Vec<&'l Nuclide<'l>>,
+    samplers: Vec<NuclideSampler>,
+    activities: Option<AliasTable>,
+}
+
+impl<'l> EventGenerator<'l> {
+    /// Creates generator for `mixture` at `time`, i.e. nuclides are chosen with weights of their activities at `time`
+    pub fn new(mixture: &NuclideMixture<'l>, time: f64) -> Self {
+        let mut tmp = core::mem::MaybeUninit::uninit();
+        let activities = mixture.activities_local(&mut tmp, time);
+        Self::from_activities(
+            activities
+                .iter()
+                .map(|&NuclideActivityPair { nuclide, activity }| (nuclide, activity)),
+        )
+    }
+
+    /// Creates generator from nuclide activities directly
+    ///
+    /// Nuclides with zero activity (in particular, stable ones) are ignored
+    pub fn from_activities(activities: impl IntoIterator<Item = (&'l Nuclide<'l>, f64)>) -> Self {
+        let mut nuclides = Vec::new();
+        let mut weights = Vec::new();
+        for (nuclide, activity) in activities {
+            if activity > 0.0 && !nuclide.decays_to_children.is_empty() {
+                nuclides.push(nuclide);
+                weights.push(activity);
+            }
+        }
+        let samplers = nuclides
+            .iter()
+            .map(|nuclide| NuclideSampler::new(nuclide))
+            .collect();
+        Self {
+            nuclides,
+            samplers,
+            activities: AliasTable::new(&weights),
+        }
+    }
+
+    /// Nuclides events are sampled from, indexed by [`DecayEvent::nuclide`]
+    #[inline]
+    pub fn nuclides(&self) -> &[&'l Nuclide<'l>] {
+        &self.nuclides
+    }
+
+    /// Total activity of the nuclides events are sampled from
+    ///
+    /// Expected number of events over a (short) time `dt` is `total_activity() * dt`
+    #[inline]
+    pub fn total_activity(&self) -> f64 {
+        self.activities
+            .as_ref()
+            .map_or(0.0, AliasTable::total_weight)
+    }
+
+    /// Samples a single event, appending it to `buffer`
+    ///
+    /// ### Returns
+    /// `false` if there's nothing to sample (there were no active nuclides), `true` otherwise
+    #[inline]
+    pub fn sample(&self, rng: &mut Rng, buffer: &mut EventBuffer) -> bool {
+        let Some(activities) = &self.activities else {
+            return false;
+        };
+        let nuclide = activities.sample(rng);
+        let sampler = &self.samplers[nuclide];
+        // nuclides without transitions were filtered out, but branch ratios may still be zero
+        let transition = sampler.transitions.as_ref().map_or(0, |t| t.sample(rng));
+        let first_particle = buffer.particles.len();
+        sampler.samplers[transition].sample(rng, &mut buffer.particles);
+        buffer.events.push(DecayEvent {
+            nuclide: nuclide as u32,
+            transition: transition as u32,
+            first_particle: first_particle as u32,
+            num_particles: (buffer.particles.len() - first_particle) as u32,
+        });
+        true
+    }
+
+    /// Samples `count` events, appending them to `buffer`
+    ///
+    /// ### Returns
+    /// Number of actually generated events (either `count`, or zero if there's nothing to sample)
+    pub fn generate(&self, rng: &mut Rng, count: usize, buffer: &mut EventBuffer) -> usize {
+        if self.activities.is_none() {
+            return 0;
+        }
+        buffer.events.reserve(count);
+        for _ in 0..count {
+            self.sample(rng, buffer);
+        }
+        count
+    }
+
+    /// Samples `count` events in total, split between `threads` threads
+    ///
+    /// Thread number `i` uses [`Rng::stream`]`(seed, i)`, so the result is reproducible for the same `seed` and `threads`. Buffers are returned in thread order, one for each thread that got any events (i.e. `min(count, threads)` of them)
+    #[cfg(feature = "std")]
+    pub fn generate_parallel(&self, seed: u64, count: usize, threads: usize) -> Vec<EventBuffer> {
+        crate::parallel::map(count, threads, |thread, events| {
+            let mut rng = Rng::stream(seed, thread as u64);
+            let mut buffer = EventBuffer::new();
+            self.generate(&mut rng, events.len(), &mut buffer);
+            buffer
+        })
+    }
+}
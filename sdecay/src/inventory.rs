@@ -0,0 +1,449 @@
+//! Copy-on-write inventories, sharing solved decay chains between variants
+//!
+//! Evolution of a mixture is a superposition of evolutions of it's initial nuclides (parents), each scaled by it's initial number of atoms. [`ChainSolution`] holds solved evolution of a single parent's decay chain, per atom of the parent; [`Inventory`] is a list of reference-counted chain solutions with their amounts.
+//!
+//! Cloning an [`Inventory`] is $O(1)$: it only increments a reference count. Modifying a clone copies the parent list (pointers only), and solves only the chains that were not solved before — see [`ChainCache`] to share chain solutions between inventories. This makes deriving thousands of what-if variants from a single base inventory cheap.
+//!
+//! Chain solutions are plain Rust tables ([`SolvedMixture`]) rather than `SandiaDecay` mixtures, since C++ mixtures (stored in any [`Container`](crate::container::Container)) can not share parts of their solution.
+//!
+//! Unsafe: no
+
+use alloc::{collections::BTreeMap, sync::Arc, vec::Vec};
+use std::sync::{Mutex, PoisonError};
+
+use crate::{
+    lines::nuclide_key,
+    overlay::{Overlay, OverlayError},
+    solved::SolvedMixture,
+    wrapper::{Nuclide, NuclideMixture},
+};
+
+/// Panic message of functions, that do not expect degenerate chains
+const DEGENERATE: &str = "chain should not be degenerate with applied corrections";
+
+/// Solved decay chain of a single parent nuclide, per atom of the parent
+#[derive(Debug)]
+pub struct ChainSolution<'l> {
+    parent: &'l Nuclide<'l>,
+    solved: SolvedMixture<'l>,
+}
+
+impl<'l> ChainSolution<'l> {
+    /// Solves decay chain of the `parent`
+    pub fn new(parent: &'l Nuclide<'l>) -> Self {
+        let mut mixture = crate::Mixture::new();
+        mixture.add_nuclide_by_abundance(parent, 1.0);
+        let solved = mixture.solve();
+        Self { parent, solved }
+    }
+
+    /// Solves decay chain of the `parent`, with half-lives corrected by `overlay`
+    ///
+    /// ### Returns
+    /// [`Option::None`], if the chain is degenerate with corrected half-lives (see [`Overlay::solve`]). Chains not affected by the overlay are solved by `SandiaDecay`, and are never [`Option::None`]
+    pub fn with_overlay(parent: &'l Nuclide<'l>, overlay: &Overlay<'l>) -> Option<Self> {
+        if !overlay.affects_chain(parent) {
+            return Some(Self::new(parent));
+        }
+        let solved = overlay.solve(&[(parent, 1.0)])?;
+        Some(Self { parent, solved })
+    }
+
+    /// Parent nuclide
+    #[inline]
+    pub fn parent(&self) -> &'l Nuclide<'l> {
+        self.parent
+    }
+
+    /// Solved chain, for a single atom of the parent at $t = 0$
+    #[inline]
+    pub fn solved(&self) -> &SolvedMixture<'l> {
+        &self.solved
+    }
+}
+
+/// Thread-safe cache of [`ChainSolution`]s, keyed by parent nuclide
+///
+/// Inventories using the same cache solve each chain at most once
+///
+/// Database corrections are applied with [`ChainCache::apply_overlay`]
+#[derive(Debug, Default)]
+pub struct ChainCache<'l> {
+    chains: Mutex<BTreeMap<usize, Arc<ChainSolution<'l>>>>,
+    overlay: Mutex<Arc<Overlay<'l>>>,
+}
+
+impl<'l> ChainCache<'l> {
+    /// Creates empty cache
+    #[inline]
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Gets chain solution for the `parent`, solving it if it's not in the cache yet
+    ///
+    /// ### Panics
+    /// If the chain is degenerate with applied corrections, see [`ChainCache::try_get`]
+    pub fn get(&self, parent: &'l Nuclide<'l>) -> Arc<ChainSolution<'l>> {
+        self.try_get(parent).expect(DEGENERATE)
+    }
+
+    /// Same as [`ChainCache::get`], but does not panic on degenerate chains
+    ///
+    /// ### Returns
+    /// [`Option::None`], if the chain is degenerate with applied corrections (see [`ChainSolution::with_overlay`])
+    pub fn try_get(&self, parent: &'l Nuclide<'l>) -> Option<Arc<ChainSolution<'l>>> {
+        let key = nuclide_key(parent);
+        loop {
+            if let Some(chain) = self.lock().get(&key) {
+                return Some(Arc::clone(chain));
+            }
+            // solve outside of the lock; a concurrent solution of the same chain is harmless
+            let overlay = self.overlay();
+            let chain = ChainSolution::with_overlay(parent, &overlay);
+            let mut chains = self.lock();
+            // corrections applied meanwhile could not re-solve this chain, so it's solved again
+            if !Arc::ptr_eq(&overlay, &self.overlay()) {
+                continue;
+            }
+            let chain = Arc::new(chain?);
+            return Some(Arc::clone(chains.entry(key).or_insert(chain)));
+        }
+    }
+
+    /// Same as [`ChainCache::try_get`], but reports degenerate chain as an error
+    fn try_chain(&self, parent: &'l Nuclide<'l>) -> Result<Arc<ChainSolution<'l>>, OverlayError> {
+        self.try_get(parent)
+            .ok_or_else(|| OverlayError::DegenerateChain(parent.symbol.to_string()))
+    }
+
+    /// Solves chains of all the `parents` not in the cache yet, splitting them between `threads`
+    ///
+    /// Chains of different parents are independent, so they are solved concurrently. Degenerate chains (see [`ChainCache::try_get`]) are skipped
+    pub fn prefetch(&self, parents: &[&'l Nuclide<'l>], threads: usize) {
+        let missing = {
+            let chains = self.lock();
+            let mut missing = parents
+                .iter()
+                .copied()
+                .filter(|parent| !chains.contains_key(&nuclide_key(parent)))
+                .collect::<Vec<_>>();
+            missing.sort_unstable_by_key(|parent| nuclide_key(parent));
+            missing.dedup_by_key(|parent| nuclide_key(parent));
+            missing
+        };
+        crate::parallel::map(missing.len(), threads, |_, parents| {
+            for &parent in &missing[parents] {
+                self.try_get(parent);
+            }
+        });
+    }
+
+    /// Applies database corrections from `overlay` on top of previously applied ones
+    ///
+    /// Only cached chains containing a nuclide with corrected half-life are re-solved; the rest are kept as-is. Chains solved later are solved with all the applied corrections. Inventories keep chain solutions they already hold, so re-create them from the cache to pick up the corrections
+    ///
+    /// Cache is locked for the whole update, so that no chain solved with previous corrections is inserted after it
+    ///
+    /// ### Returns
+    /// Number of re-solved chains
+    ///
+    /// ### Errors
+    /// [`OverlayError::DegenerateChain`], if any of the cached chains is degenerate with applied corrections. Overlay is not applied then, and cache is left intact
+    pub fn apply_overlay(&self, overlay: &Overlay<'l>) -> Result<usize, OverlayError> {
+        let mut chains = self.lock();
+        let mut combined = Overlay::clone(&self.overlay());
+        combined.extend(overlay);
+        let mut resolved = Vec::new();
+        if overlay.corrected_nuclides().next().is_some() {
+            for chain in chains.values() {
+                if !overlay.affects_solution(chain.solved().nuclides().iter().copied()) {
+                    continue;
+                }
+                let parent = chain.parent();
+                let chain = ChainSolution::with_overlay(parent, &combined)
+                    .ok_or_else(|| OverlayError::DegenerateChain(parent.symbol.to_string()))?;
+                resolved.push(Arc::new(chain));
+            }
+        }
+        *self.overlay.lock().unwrap_or_else(PoisonError::into_inner) = Arc::new(combined);
+        let count = resolved.len();
+        for chain in resolved {
+            chains.insert(nuclide_key(chain.parent()), chain);
+        }
+        Ok(count)
+    }
+
+    /// Currently applied corrections
+    ///
+    /// Lock order is `chains` first, then `overlay`
+    fn overlay(&self) -> Arc<Overlay<'l>> {
+        Arc::clone(&self.overlay.lock().unwrap_or_else(PoisonError::into_inner))
+    }
+
+    /// Number of cached chains
+    pub fn len(&self) -> usize {
+        self.lock().len()
+    }
+
+    /// Checks if cache is empty
+    pub fn is_empty(&self) -> bool {
+        self.lock().is_empty()
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, BTreeMap<usize, Arc<ChainSolution<'l>>>> {
+        // map is never left in inconsistent state
+        self.chains.lock().unwrap_or_else(PoisonError::into_inner)
+    }
+}
+
+/// Copy-on-write nuclide inventory, see [module-level docs](self)
+#[derive(Debug, Clone, Default)]
+pub struct Inventory<'l> {
+    parents: Arc<Vec<(Arc<ChainSolution<'l>>, f64)>>,
+}
+
+impl<'l> Inventory<'l> {
+    /// Creates empty inventory
+    #[inline]
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Creates inventory with the same initial nuclides as `mixture`
+    ///
+    /// Mixture is solved once to obtain it's initial nuclides; chains are taken from (or added to) `cache`
+    ///
+    /// ### Panics
+    /// If any of the chains is degenerate with corrections applied to the `cache`, see [`Inventory::try_from_mixture`]
+    pub fn from_mixture(mixture: &NuclideMixture<'l>, cache: &ChainCache<'l>) -> Self {
+        Self::try_from_mixture(mixture, cache).expect(DEGENERATE)
+    }
+
+    /// Same as [`Inventory::from_mixture`], but does not panic on degenerate chains
+    ///
+    /// ### Errors
+    /// [`OverlayError::DegenerateChain`], if any of the chains is degenerate with corrections applied to the `cache` (see [`ChainCache::try_get`])
+    pub fn try_from_mixture(
+        mixture: &NuclideMixture<'l>,
+        cache: &ChainCache<'l>,
+    ) -> Result<Self, OverlayError> {
+        let mut inventory = Self::new();
+        for (nuclide, atoms) in mixture.solve().initial_nuclides() {
+            inventory.add_chain(cache.try_chain(nuclide)?, atoms);
+        }
+        Ok(inventory)
+    }
+
+    /// Creates inventory of `parents` with their initial numbers of atoms, solving their chains on `threads` (see [`ChainCache::prefetch`])
+    ///
+    /// Parent order (and thus [`Inventory::solve`] result) is the same as in `parents`, regardless of number of threads
+    ///
+    /// ### Panics
+    /// If any of the chains is degenerate with corrections applied to the `cache`, see [`Inventory::try_from_nuclides_parallel`]
+    pub fn from_nuclides_parallel(
+        parents: &[(&'l Nuclide<'l>, f64)],
+        cache: &ChainCache<'l>,
+        threads: usize,
+    ) -> Self {
+        Self::try_from_nuclides_parallel(parents, cache, threads).expect(DEGENERATE)
+    }
+
+    /// Same as [`Inventory::from_nuclides_parallel`], but does not panic on degenerate chains
+    ///
+    /// ### Errors
+    /// [`OverlayError::DegenerateChain`] for the first of `parents` with a degenerate chain (see [`ChainCache::try_get`])
+    pub fn try_from_nuclides_parallel(
+        parents: &[(&'l Nuclide<'l>, f64)],
+        cache: &ChainCache<'l>,
+        threads: usize,
+    ) -> Result<Self, OverlayError> {
+        let nuclides = parents
+            .iter()
+            .map(|&(nuclide, _)| nuclide)
+            .collect::<Vec<_>>();
+        cache.prefetch(&nuclides, threads);
+        let mut inventory = Self::new();
+        for &(nuclide, atoms) in parents {
+            inventory.add_chain(cache.try_chain(nuclide)?, atoms);
+        }
+        Ok(inventory)
+    }
+
+    /// Number of parent nuclides
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.parents.len()
+    }
+
+    /// Checks if inventory has no nuclides
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.parents.is_empty()
+    }
+
+    /// Parent nuclides with their initial numbers of atoms
+    pub fn parents(&self) -> impl ExactSizeIterator<Item = (&'l Nuclide<'l>, f64)> + '_ {
+        self.parents
+            .iter()
+            .map(|(chain, atoms)| (chain.parent(), *atoms))
+    }
+
+    /// Checks if two inventories share the same parent list (i.e. one is an unmodified clone of another)
+    #[inline]
+    pub fn shares_parents_with(&self, other: &Self) -> bool {
+        Arc::ptr_eq(&self.parents, &other.parents)
+    }
+
+    /// Adds `atoms` of the parent of solved `chain`
+    ///
+    /// If parent is already in the inventory, atoms are added to it's amount. Nothing is re-solved
+    pub fn add_chain(&mut self, chain: Arc<ChainSolution<'l>>, atoms: f64) {
+        let parents = Arc::make_mut(&mut self.parents);
+        let key = nuclide_key(chain.parent());
+        match parents
+            .iter_mut()
+            .find(|(existing, _)| nuclide_key(existing.parent()) == key)
+        {
+            Some((_, existing)) => *existing += atoms,
+            None => parents.push((chain, atoms)),
+        }
+    }
+
+    /// Adds `atoms` of the `nuclide`, solving only it's chain (unless it's in the `cache` already)
+    ///
+    /// ### Panics
+    /// If the chain is degenerate with corrections applied to the `cache`, see [`Inventory::try_add_nuclide_by_atoms`]
+    #[inline]
+    pub fn add_nuclide_by_atoms(
+        &mut self,
+        nuclide: &'l Nuclide<'l>,
+        atoms: f64,
+        cache: &ChainCache<'l>,
+    ) {
+        self.add_chain(cache.get(nuclide), atoms);
+    }
+
+    /// Same as [`Inventory::add_nuclide_by_atoms`], but does not panic on degenerate chains
+    ///
+    /// ### Errors
+    /// [`OverlayError::DegenerateChain`], if the chain is degenerate with corrections applied to the `cache` (see [`ChainCache::try_get`]). Inventory is left intact then
+    pub fn try_add_nuclide_by_atoms(
+        &mut self,
+        nuclide: &'l Nuclide<'l>,
+        atoms: f64,
+        cache: &ChainCache<'l>,
+    ) -> Result<(), OverlayError> {
+        self.add_chain(cache.try_chain(nuclide)?, atoms);
+        Ok(())
+    }
+
+    /// Adds `nuclide` with initial `activity`, see [`Inventory::add_nuclide_by_atoms`]
+    ///
+    /// ### Panics
+    /// See [`Inventory::add_nuclide_by_atoms`]
+    #[inline]
+    pub fn add_nuclide_by_activity(
+        &mut self,
+        nuclide: &'l Nuclide<'l>,
+        activity: f64,
+        cache: &ChainCache<'l>,
+    ) {
+        self.add_nuclide_by_atoms(nuclide, activity / nuclide.decay_constant(), cache);
+    }
+
+    /// Removes parent `nuclide`
+    ///
+    /// ### Returns
+    /// Removed number of atoms, or [`Option::None`] if nuclide is not a parent in this inventory
+    pub fn remove_nuclide(&mut self, nuclide: &Nuclide<'_>) -> Option<f64> {
+        let key = nuclide_key(nuclide);
+        let position = self
+            .parents
+            .iter()
+            .position(|(chain, _)| nuclide_key(chain.parent()) == key)?;
+        Some(Arc::make_mut(&mut self.parents).remove(position).1)
+    }
+
+    /// Number of atoms of the `nuclide` at `time`, summed over all the chains
+    pub fn num_atoms(&self, time: f64, nuclide: &Nuclide<'_>) -> f64 {
+        self.parents
+            .iter()
+            .filter_map(|(chain, atoms)| Some(atoms * chain.solved().num_atoms(time, nuclide)?))
+            .sum()
+    }
+
+    /// Activity of the `nuclide` at `time`, summed over all the chains
+    pub fn activity(&self, time: f64, nuclide: &Nuclide<'_>) -> f64 {
+        self.parents
+            .iter()
+            .filter_map(|(chain, atoms)| Some(atoms * chain.solved().activity(time, nuclide)?))
+            .sum()
+    }
+
+    /// Total activity at `time`
+    pub fn total_activity(&self, time: f64) -> f64 {
+        self.parents
+            .iter()
+            .map(|(chain, atoms)| atoms * chain.solved().total_activity(time))
+            .sum()
+    }
+
+    /// Merges all the chains into a single [`SolvedMixture`]
+    ///
+    /// Terms with equal exponents are combined, so shared descendants are not evaluated once per chain
+    pub fn solve(&self) -> SolvedMixture<'l> {
+        let mut positions = BTreeMap::new();
+        let mut nuclides = Vec::new();
+        let mut decay_constants = Vec::new();
+        let mut terms: Vec<Vec<(f64, f64)>> = Vec::new();
+        for (chain, atoms) in self.parents.iter() {
+            let solved = chain.solved();
+            for (index, &nuclide) in solved.nuclides().iter().enumerate() {
+                let position = *positions.entry(nuclide_key(nuclide)).or_insert_with(|| {
+                    nuclides.push(nuclide);
+                    decay_constants.push(solved.decay_constants()[index]);
+                    terms.push(Vec::new());
+                    nuclides.len() - 1
+                });
+                let (coefficients, exponents) = solved.terms(index);
+                terms[position].extend(
+                    exponents
+                        .iter()
+                        .zip(coefficients)
+                        .map(|(&k, &c)| (k, c * atoms)),
+                );
+            }
+        }
+        let mut term_offsets = Vec::with_capacity(nuclides.len() + 1);
+        let mut coefficients = Vec::new();
+        let mut exponents = Vec::new();
+        for mut terms in terms {
+            term_offsets.push(coefficients.len());
+            terms.sort_by(|(a, _), (b, _)| a.total_cmp(b));
+            let start = exponents.len();
+            for (k, c) in terms {
+                if exponents.len() > start && exponents.last() == Some(&k) {
+                    *coefficients.last_mut().expect("lengths are equal") += c;
+                } else {
+                    exponents.push(k);
+                    coefficients.push(c);
+                }
+            }
+        }
+        term_offsets.push(coefficients.len());
+        let initial = self
+            .parents
+            .iter()
+            .map(|(chain, atoms)| (positions[&nuclide_key(chain.parent())] as u32, *atoms))
+            .collect();
+        SolvedMixture::from_parts(
+            nuclides,
+            decay_constants,
+            term_offsets,
+            coefficients,
+            exponents,
+            initial,
+        )
+    }
+}
@@ -0,0 +1,277 @@
+//! Lazily solved mixtures, solving evolution of a nuclide only when it's first queried
+//!
+//! `SandiaDecay` solves evolution of every descendant of every initial nuclide at once, even if only a couple of them are ever queried. [`LazyMixture`] solves evolution of a nuclide on it's first query (or once for a declared subset, see [`LazyMixture::solve_subset`]), and caches it.
+//!
+//! Evolution of a descendant is obtained with analytic Bateman solution, summed over all the decay paths from initial nuclides to it. For a path $1 \to 2 \to \dots \to n$ with branch ratios $b_i$ and decay constants $\lambda_i$,
+//! $$
+//! N_n(t) = N_1(0) \prod_{i=1}^{n-1} b_i \lambda_i \sum_{j=1}^n \frac{e^{-\lambda_j t}}{\prod_{k \ne j} (\lambda_k - \lambda_j)}
+//! $$
+//! so only the nuclides along the paths are visited. Paths with (nearly) equal decay constants make this formula degenerate; for these, entire chain of the initial nuclide is solved with `SandiaDecay` instead.
+//!
+//! Unsafe: no
+
+use alloc::{collections::BTreeMap, sync::Arc, vec::Vec};
+use std::sync::Mutex;
+
+use crate::{
+    inventory::ChainSolution,
+    lines::nuclide_key,
+    solved::SolvedMixture,
+    wrapper::{Nuclide, term_integral},
+};
+
+/// Relative difference of decay constants, below which Bateman solution is considered degenerate
+const DEGENERATE_TOLERANCE: f64 = 1e-9;
+
+/// Limit on decay path length, guarding against malformed (cyclic) decay data
+const MAX_PATH_LENGTH: usize = 64;
+
+/// Solved evolution of a single nuclide, $N(t) = \sum_i c_i e^{-k_i t}$
+#[derive(Debug, Default)]
+struct Evolution {
+    coefficients: Vec<f64>,
+    exponents: Vec<f64>,
+}
+
+impl Evolution {
+    fn num_atoms(&self, time: f64) -> f64 {
+        self.coefficients
+            .iter()
+            .zip(&self.exponents)
+            .map(|(c, k)| c * (-k * time).exp())
+            .sum()
+    }
+}
+
+/// Lazily solved nuclide mixture, see [module-level docs](self)
+#[derive(Debug, Default)]
+pub struct LazyMixture<'l> {
+    initial: Vec<(&'l Nuclide<'l>, f64)>,
+    solved: Mutex<BTreeMap<usize, Arc<Evolution>>>,
+}
+
+impl<'l> LazyMixture<'l> {
+    /// Creates empty mixture
+    #[inline]
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Adds `atoms` of the `nuclide` at $t = 0$
+    ///
+    /// Nothing is solved, but previously solved evolutions are discarded
+    pub fn add_nuclide_by_atoms(&mut self, nuclide: &'l Nuclide<'l>, atoms: f64) {
+        let key = nuclide_key(nuclide);
+        match self
+            .initial
+            .iter_mut()
+            .find(|(existing, _)| nuclide_key(existing) == key)
+        {
+            Some((_, existing)) => *existing += atoms,
+            None => self.initial.push((nuclide, atoms)),
+        }
+        self.lock().clear();
+    }
+
+    /// Adds `nuclide` with initial `activity`, see [`LazyMixture::add_nuclide_by_atoms`]
+    #[inline]
+    pub fn add_nuclide_by_activity(&mut self, nuclide: &'l Nuclide<'l>, activity: f64) {
+        self.add_nuclide_by_atoms(nuclide, activity / nuclide.decay_constant());
+    }
+
+    /// Initial nuclides and their numbers of atoms
+    #[inline]
+    pub fn initial_nuclides(&self) -> &[(&'l Nuclide<'l>, f64)] {
+        &self.initial
+    }
+
+    /// Number of nuclides, evolution of which was solved so far
+    pub fn num_solved(&self) -> usize {
+        self.lock().len()
+    }
+
+    /// Number of atoms of the `nuclide` at `time`
+    ///
+    /// Solves nuclide's evolution on the first call. Nuclides not descending from any of the initial nuclides have no atoms
+    pub fn num_atoms(&self, time: f64, nuclide: &Nuclide<'_>) -> f64 {
+        self.evolution(nuclide).num_atoms(time)
+    }
+
+    /// Activity of the `nuclide` at `time`, see [`LazyMixture::num_atoms`]
+    #[inline]
+    pub fn activity(&self, time: f64, nuclide: &Nuclide<'_>) -> f64 {
+        self.num_atoms(time, nuclide) * nuclide.decay_constant()
+    }
+
+    /// Number of decays of the `nuclide` in time interval $[t_0; t_1]$, see [`LazyMixture::num_atoms`]
+    pub fn num_decays(&self, t0: f64, t1: f64, nuclide: &Nuclide<'_>) -> f64 {
+        let evolution = self.evolution(nuclide);
+        let atom_seconds = evolution
+            .coefficients
+            .iter()
+            .zip(&evolution.exponents)
+            .map(|(&c, &k)| term_integral(c, k, t0, t1))
+            .sum::<f64>();
+        atom_seconds * nuclide.decay_constant()
+    }
+
+    /// Solves evolution of declared subset of `nuclides` only, into a [`SolvedMixture`]
+    ///
+    /// Resulting mixture contains only these nuclides (in the same order, duplicates removed), so all of it's queries (including [`SolvedMixture::total_activity`]) are restricted to the subset. Initial nuclides not in the subset are not listed in [`SolvedMixture::initial_nuclides`]
+    pub fn solve_subset(&self, nuclides: &[&'l Nuclide<'l>]) -> SolvedMixture<'l> {
+        let mut seen = Vec::with_capacity(nuclides.len());
+        let mut subset = Vec::with_capacity(nuclides.len());
+        let mut decay_constants = Vec::with_capacity(nuclides.len());
+        let mut term_offsets = Vec::with_capacity(nuclides.len() + 1);
+        let mut coefficients = Vec::new();
+        let mut exponents = Vec::new();
+        for &nuclide in nuclides {
+            let key = nuclide_key(nuclide);
+            if seen.contains(&key) {
+                continue;
+            }
+            seen.push(key);
+            let evolution = self.evolution(nuclide);
+            subset.push(nuclide);
+            decay_constants.push(nuclide.decay_constant());
+            term_offsets.push(coefficients.len());
+            coefficients.extend_from_slice(&evolution.coefficients);
+            exponents.extend_from_slice(&evolution.exponents);
+        }
+        term_offsets.push(coefficients.len());
+        let initial = self
+            .initial
+            .iter()
+            .filter_map(|(nuclide, atoms)| {
+                let key = nuclide_key(nuclide);
+                let index = seen.iter().position(|&seen| seen == key)?;
+                Some((index as u32, *atoms))
+            })
+            .collect();
+        SolvedMixture::from_parts(
+            subset,
+            decay_constants,
+            term_offsets,
+            coefficients,
+            exponents,
+            initial,
+        )
+    }
+
+    /// Gets cached evolution of the `nuclide`, solving it if needed
+    fn evolution(&self, nuclide: &Nuclide<'_>) -> Arc<Evolution> {
+        let key = nuclide_key(nuclide);
+        if let Some(evolution) = self.lock().get(&key) {
+            return Arc::clone(evolution);
+        }
+        // solve outside of the lock; a concurrent solution of the same nuclide is harmless
+        let evolution = Arc::new(self.solve(key));
+        Arc::clone(self.lock().entry(key).or_insert(evolution))
+    }
+
+    /// Sums Bateman solutions over all the decay paths leading to nuclide with `key`
+    fn solve(&self, key: usize) -> Evolution {
+        let mut terms = Vec::new();
+        let mut path = Vec::new();
+        for &(parent, atoms) in &self.initial {
+            path.clear();
+            let start = terms.len();
+            if !collect_paths(parent, 1.0, key, atoms, &mut path, &mut terms) {
+                // degenerate path: fall back to solving entire chain
+                terms.truncate(start);
+                let chain = ChainSolution::new(parent);
+                let solved = chain.solved();
+                if let Some(index) = solved.nuclides().iter().position(|n| nuclide_key(n) == key) {
+                    let (coefficients, exponents) = solved.terms(index);
+                    terms.extend(
+                        exponents
+                            .iter()
+                            .zip(coefficients)
+                            .map(|(&k, &c)| (k, c * atoms)),
+                    );
+                }
+            }
+        }
+        terms.sort_by(|(a, _), (b, _)| a.total_cmp(b));
+        let mut evolution = Evolution::default();
+        for (k, c) in terms {
+            if evolution.exponents.last() == Some(&k) {
+                *evolution
+                    .coefficients
+                    .last_mut()
+                    .expect("lengths are equal") += c;
+            } else {
+                evolution.exponents.push(k);
+                evolution.coefficients.push(c);
+            }
+        }
+        evolution
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, BTreeMap<usize, Arc<Evolution>>> {
+        // map is never left in inconsistent state
+        self.solved
+            .lock()
+            .unwrap_or_else(std::sync::PoisonError::into_inner)
+    }
+}
+
+/// Depth-first search of decay paths from `nuclide` (reached with cumulative branch ratio `branch`) to nuclide with `target` key, appending `(exponent, coefficient)` terms of each path
+///
+/// ### Returns
+/// `false`, if some path is degenerate
+fn collect_paths<'l>(
+    nuclide: &'l Nuclide<'l>,
+    branch: f64,
+    target: usize,
+    atoms: f64,
+    path: &mut Vec<f64>,
+    terms: &mut Vec<(f64, f64)>,
+) -> bool {
+    if path.len() >= MAX_PATH_LENGTH {
+        return true;
+    }
+    path.push(nuclide.decay_constant());
+    let mut regular = true;
+    if nuclide_key(nuclide) == target {
+        regular = bateman(path, atoms * branch, terms);
+    } else {
+        for transition in &nuclide.decays_to_children {
+            let Some(child) = transition.child else {
+                continue;
+            };
+            let branch = branch * f64::from(transition.branch_ratio);
+            if branch > 0.0 {
+                regular &= collect_paths(child, branch, target, atoms, path, terms);
+            }
+        }
+    }
+    path.pop();
+    regular
+}
+
+/// Appends Bateman solution terms of the last nuclide on a linear path with `decay_constants`, given `scale` atoms of the first nuclide (including branch ratios along the path)
+///
+/// ### Returns
+/// `false`, if solution is degenerate
+fn bateman(decay_constants: &[f64], scale: f64, terms: &mut Vec<(f64, f64)>) -> bool {
+    let (_, feeding) = decay_constants
+        .split_last()
+        .expect("path contains at least the target");
+    let scale = scale * feeding.iter().product::<f64>();
+    for (j, &lambda_j) in decay_constants.iter().enumerate() {
+        let mut denominator = 1.0;
+        for (k, &lambda_k) in decay_constants.iter().enumerate() {
+            if k == j {
+                continue;
+            }
+            let difference = lambda_k - lambda_j;
+            if difference.abs() <= DEGENERATE_TOLERANCE * lambda_k.abs().max(lambda_j.abs()) {
+                return false;
+            }
+            denominator *= difference;
+        }
+        terms.push((lambda_j, scale / denominator));
+    }
+    true
+}
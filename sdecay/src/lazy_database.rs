@@ -0,0 +1,486 @@
+//! Lazily materialized database, for services that mostly need nuclides and their decay graph
+//!
+//! `SandiaDecay` initialization materializes every transition and every particle (with coincidences) of every nuclide up front, even if only half-lives and branch ratios are ever used. [`LazyDatabase`] is built on Rust side (see [`crate::scan`]) from the database XML, which it retains:
+//! - nuclide headers (symbol, $Z$, $A$, isomer number, atomic mass, half-life) and the decay graph (transitions with their modes and branch ratios) are built eagerly
+//! - particles of a transition are parsed from the retained XML on first access to [`LazyTransition::particles`], and cached. This is thread-safe: concurrent first accesses parse the transition at most once
+//!
+//! Content of transition elements is skipped during initialization, so it costs a single pass of byte searches over it. Particle element names follow `SandiaDecay`'s schema (`gamma`, `xray`, `beta`, `positron`, `alpha`, `electronCapture`), along with their `coincidence` children; other particle data (hindrance, $\log ft$, forbiddenness) is not materialized.
+//!
+//! Note, that evolution solvers ([`NuclideMixture`](crate::wrapper::NuclideMixture), [`SolvedMixture`](crate::solved::SolvedMixture), [`Inventory`](crate::inventory::Inventory), [`LazyMixture`](crate::lazy::LazyMixture), etc) work with nuclides of initialized `SandiaDecay` database, and do not accept [`LazyNuclide`]s. Lazy database is meant for lookups and graph traversal; to evolve a mixture, initialize the database and look the nuclides up by [`LazyNuclide::symbol`].
+//!
+//! Unsafe: no
+
+use alloc::{boxed::Box, string::String, vec::Vec};
+use core::ops::Range;
+use std::{path::Path, sync::OnceLock};
+
+use crate::{
+    scan::{NuclideHeader, ScanError, number},
+    wrapper::{CoincidencePair, DecayMode, ProductType},
+    xml,
+};
+
+/// Error while initializing [`LazyDatabase`]
+#[derive(Debug, Error)]
+pub enum LazyInitError {
+    /// Failed to read database file
+    #[error("Failed to read database: {0}")]
+    Io(#[from] std::io::Error),
+    /// Database is not valid UTF-8
+    #[error("Database is not valid UTF-8: {0}")]
+    Utf8(#[from] alloc::string::FromUtf8Error),
+    /// Database is malformed
+    #[error(transparent)]
+    Scan(#[from] ScanError),
+    /// Transition references nuclide not defined in the database
+    #[error("Transition at byte {0} references unknown nuclide")]
+    UnknownNuclide(usize),
+}
+
+/// Nuclide header, with symbol stored as a range of the retained XML
+#[derive(Debug)]
+struct NuclideEntry {
+    symbol: Range<usize>,
+    atomic_number: i16,
+    mass_number: i16,
+    isomer_number: i16,
+    atomic_mass: f32,
+    half_life: f64,
+    /// Range of [`LazyDatabase::transitions`], where this nuclide is the parent
+    children: Range<usize>,
+}
+
+/// Transition, with particles materialized on demand
+#[derive(Debug)]
+struct TransitionEntry {
+    parent: usize,
+    child: Option<usize>,
+    mode: DecayMode,
+    branch_ratio: f32,
+    content: Range<usize>,
+    particles: OnceLock<Result<Box<[Particle]>, ScanError>>,
+}
+
+/// Parent of a transition, before symbols are resolved
+enum Parent {
+    /// Enclosing nuclide element
+    Index(usize),
+    /// Range of parent's symbol in the XML
+    Symbol(Range<usize>),
+}
+
+/// Particle emitted along a transition
+#[derive(Debug, Clone, PartialEq)]
+pub struct Particle {
+    /// Particle type
+    pub r#type: ProductType,
+    /// Particle energy, in `SandiaDecay` units
+    pub energy: f32,
+    /// Number of particles emitted per decay through the transition
+    pub intensity: f32,
+    /// Particles coincident with this one, same as [`RadParticle::coincidences`](crate::wrapper::RadParticle::coincidences)
+    ///
+    /// Indices refer to [`LazyTransition::particles`]
+    pub coincidences: Box<[CoincidencePair]>,
+}
+
+/// Lazily materialized database, see [module-level docs](self)
+#[derive(Debug)]
+pub struct LazyDatabase {
+    xml: String,
+    nuclides: Vec<NuclideEntry>,
+    /// Indices of [`LazyDatabase::nuclides`], sorted by symbol
+    by_symbol: Vec<usize>,
+    /// Sorted by parent
+    transitions: Vec<TransitionEntry>,
+}
+
+impl LazyDatabase {
+    /// Reads database XML from `path`, see [`LazyDatabase::from_xml`]
+    ///
+    /// ### Errors
+    /// See [`LazyInitError`] variants
+    pub fn from_path(path: impl AsRef<Path>) -> Result<Self, LazyInitError> {
+        Self::from_bytes(std::fs::read(path)?)
+    }
+
+    /// Takes ownership of database XML `bytes`, see [`LazyDatabase::from_xml`]
+    ///
+    /// Trailing null bytes are ignored
+    ///
+    /// ### Errors
+    /// See [`LazyInitError`] variants
+    pub fn from_bytes(mut bytes: Vec<u8>) -> Result<Self, LazyInitError> {
+        while bytes.last() == Some(&0) {
+            bytes.pop();
+        }
+        Self::from_xml(String::from_utf8(bytes)?)
+    }
+
+    /// Builds nuclide headers and decay graph from database `xml`, and retains it to materialize particles later
+    ///
+    /// ### Errors
+    /// See [`LazyInitError`] variants
+    pub fn from_xml(xml: String) -> Result<Self, LazyInitError> {
+        let mut nuclides = Vec::new();
+        // `(offset, parent, child symbol, mode, branch ratio, content)`
+        let mut raw_transitions = Vec::new();
+        let mut tags = xml::tags(&xml);
+        while let Some(tag) = tags.next() {
+            let tag = tag.map_err(ScanError::Syntax)?;
+            match tag.name {
+                "nuclide" => {
+                    let header = NuclideHeader::from_tag(&tag)?;
+                    nuclides.push(NuclideEntry {
+                        symbol: subrange(&xml, header.symbol),
+                        atomic_number: header.atomic_number,
+                        mass_number: header.mass_number,
+                        isomer_number: header.isomer_number,
+                        atomic_mass: header.atomic_mass,
+                        half_life: header.half_life,
+                        children: 0..0,
+                    });
+                }
+                "transition" => {
+                    // transitions nested into their parent's element may omit the parent
+                    let parent = match tag.attribute("parent") {
+                        Some(parent) => Parent::Symbol(subrange(&xml, parent)),
+                        None => Parent::Index(nuclides.len().checked_sub(1).ok_or(
+                            ScanError::MissingAttribute {
+                                offset: tag.offset,
+                                attribute: "parent",
+                            },
+                        )?),
+                    };
+                    let child = tag
+                        .attribute("child")
+                        .filter(|child| !child.trim_ascii().is_empty())
+                        .map(|child| subrange(&xml, child));
+                    let mode = tag
+                        .attribute("mode")
+                        .map_or(DecayMode::UndefinedDecay, decay_mode);
+                    let branch_ratio = number(&tag, "branchRatio", xml::parse_f32)?;
+                    let offset = tag.offset;
+                    let content = if tag.is_empty {
+                        0..0
+                    } else {
+                        tags.skip_content("transition")
+                            .ok_or(ScanError::Syntax(offset))?
+                    };
+                    raw_transitions.push((offset, parent, child, mode, branch_ratio, content));
+                }
+                _ => {}
+            }
+        }
+
+        let mut by_symbol = (0..nuclides.len()).collect::<Vec<_>>();
+        by_symbol.sort_unstable_by_key(|&index| &xml[nuclides[index].symbol.clone()]);
+        let find = |symbol: Range<usize>, offset: usize| {
+            let symbol = xml[symbol].trim_ascii();
+            by_symbol
+                .binary_search_by_key(&symbol, |&index| &xml[nuclides[index].symbol.clone()])
+                .map(|position| by_symbol[position])
+                .map_err(|_| LazyInitError::UnknownNuclide(offset))
+        };
+        let mut transitions = Vec::with_capacity(raw_transitions.len());
+        for (offset, parent, child, mode, branch_ratio, content) in raw_transitions {
+            transitions.push(TransitionEntry {
+                parent: match parent {
+                    Parent::Index(parent) => parent,
+                    Parent::Symbol(symbol) => find(symbol, offset)?,
+                },
+                child: child.map(|child| find(child, offset)).transpose()?,
+                mode,
+                branch_ratio,
+                content,
+                particles: OnceLock::new(),
+            });
+        }
+        // stable, to keep transitions of each nuclide in the document order
+        transitions.sort_by_key(|transition| transition.parent);
+        let mut start = 0;
+        for (index, nuclide) in nuclides.iter_mut().enumerate() {
+            let end = start
+                + transitions[start..].partition_point(|transition| transition.parent == index);
+            nuclide.children = start..end;
+            start = end;
+        }
+        Ok(Self {
+            xml,
+            nuclides,
+            by_symbol,
+            transitions,
+        })
+    }
+
+    /// Number of nuclides in the database
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.nuclides.len()
+    }
+
+    /// Checks if database contains no nuclides
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.nuclides.is_empty()
+    }
+
+    /// Number of transitions in the database
+    #[inline]
+    pub fn num_transitions(&self) -> usize {
+        self.transitions.len()
+    }
+
+    /// Number of transitions, particles of which were materialized so far
+    pub fn num_materialized(&self) -> usize {
+        self.transitions
+            .iter()
+            .filter(|transition| transition.particles.get().is_some())
+            .count()
+    }
+
+    /// All the nuclides, in the document order
+    pub fn nuclides(&self) -> impl ExactSizeIterator<Item = LazyNuclide<'_>> + '_ {
+        (0..self.nuclides.len()).map(|index| LazyNuclide {
+            database: self,
+            index,
+        })
+    }
+
+    /// Nuclide with `symbol` (as stored in the database, e.g. `Co60`)
+    pub fn nuclide(&self, symbol: &str) -> Option<LazyNuclide<'_>> {
+        let position = self
+            .by_symbol
+            .binary_search_by_key(&symbol, |&index| self.symbol(index))
+            .ok()?;
+        Some(LazyNuclide {
+            database: self,
+            index: self.by_symbol[position],
+        })
+    }
+
+    #[inline]
+    fn symbol(&self, index: usize) -> &str {
+        &self.xml[self.nuclides[index].symbol.clone()]
+    }
+}
+
+/// Nuclide of a [`LazyDatabase`]
+#[derive(Debug, Clone, Copy)]
+pub struct LazyNuclide<'d> {
+    database: &'d LazyDatabase,
+    index: usize,
+}
+
+impl<'d> LazyNuclide<'d> {
+    #[inline]
+    fn entry(&self) -> &'d NuclideEntry {
+        &self.database.nuclides[self.index]
+    }
+
+    /// Nuclide symbol, e.g. `Co60`
+    #[inline]
+    pub fn symbol(&self) -> &'d str {
+        self.database.symbol(self.index)
+    }
+
+    /// Number of protons in the nucleus
+    #[inline]
+    pub fn atomic_number(&self) -> i16 {
+        self.entry().atomic_number
+    }
+
+    /// Number of nucleons in the nucleus
+    #[inline]
+    pub fn mass_number(&self) -> i16 {
+        self.entry().mass_number
+    }
+
+    /// Nuclear excitation state (isomer number)
+    #[inline]
+    pub fn isomer_number(&self) -> i16 {
+        self.entry().isomer_number
+    }
+
+    /// Atomic mass in a.m.u.
+    #[inline]
+    pub fn atomic_mass(&self) -> f32 {
+        self.entry().atomic_mass
+    }
+
+    /// Half-life, in units of [`crate::cst`]
+    #[inline]
+    pub fn half_life(&self) -> f64 {
+        self.entry().half_life
+    }
+
+    /// Decay constant, same as [`Nuclide::decay_constant`](crate::wrapper::Nuclide::decay_constant)
+    ///
+    /// Stable nuclides have zero decay constant
+    #[inline]
+    pub fn decay_constant(&self) -> f64 {
+        let half_life = self.half_life();
+        if half_life.is_finite() && half_life > 0.0 {
+            core::f64::consts::LN_2 / half_life
+        } else {
+            0.0
+        }
+    }
+
+    /// Transitions this nuclide decays through, in the document order
+    pub fn transitions(&self) -> impl ExactSizeIterator<Item = LazyTransition<'d>> + 'd {
+        let database = self.database;
+        self.entry()
+            .children
+            .clone()
+            .map(move |index| LazyTransition { database, index })
+    }
+}
+
+/// Transition of a [`LazyDatabase`]
+#[derive(Debug, Clone, Copy)]
+pub struct LazyTransition<'d> {
+    database: &'d LazyDatabase,
+    index: usize,
+}
+
+impl<'d> LazyTransition<'d> {
+    #[inline]
+    fn entry(&self) -> &'d TransitionEntry {
+        &self.database.transitions[self.index]
+    }
+
+    /// Parent nuclide of the decay
+    #[inline]
+    pub fn parent(&self) -> LazyNuclide<'d> {
+        LazyNuclide {
+            database: self.database,
+            index: self.entry().parent,
+        }
+    }
+
+    /// Resultant nuclide, if any
+    #[inline]
+    pub fn child(&self) -> Option<LazyNuclide<'d>> {
+        self.entry().child.map(|index| LazyNuclide {
+            database: self.database,
+            index,
+        })
+    }
+
+    /// Decay mode
+    ///
+    /// Modes not known to `SandiaDecay` are reported as [`DecayMode::UndefinedDecay`]
+    #[inline]
+    pub fn mode(&self) -> DecayMode {
+        self.entry().mode
+    }
+
+    /// A fraction of times the parent nuclide decays through this transition
+    #[inline]
+    pub fn branch_ratio(&self) -> f32 {
+        self.entry().branch_ratio
+    }
+
+    /// Particles emitted along this transition, in the document order
+    ///
+    /// Particles are parsed on the first call, and cached
+    ///
+    /// ### Errors
+    /// If particle data is malformed (error is cached as well)
+    pub fn particles(&self) -> Result<&'d [Particle], ScanError> {
+        let entry = self.entry();
+        entry
+            .particles
+            .get_or_init(|| parse_particles(&self.database.xml, entry.content.clone()))
+            .as_deref()
+            .map_err(|&error| error)
+    }
+}
+
+/// Parses particle elements in `content` range of `xml`, along with their coincidences
+fn parse_particles(xml: &str, content: Range<usize>) -> Result<Box<[Particle]>, ScanError> {
+    let base = content.start;
+    let mut particles = Vec::new();
+    let mut coincidences = Vec::new();
+    // coincidences of unknown elements are skipped along with them
+    let mut known = false;
+    for tag in xml::tags(&xml[content]) {
+        let mut tag = tag.map_err(|offset| ScanError::Syntax(base + offset))?;
+        tag.offset += base;
+        let r#type = match tag.name {
+            "coincidence" => {
+                if known {
+                    coincidences.push(CoincidencePair(
+                        number(&tag, "index", xml::parse_u16)?,
+                        number(&tag, "fraction", xml::parse_f32)?,
+                    ));
+                }
+                continue;
+            }
+            "gamma" => ProductType::GammaParticle,
+            "xray" => ProductType::XrayParticle,
+            "beta" => ProductType::BetaParticle,
+            "positron" => ProductType::PositronParticle,
+            "alpha" => ProductType::AlphaParticle,
+            "electronCapture" => ProductType::CaptureElectronParticle,
+            _ => {
+                known = false;
+                continue;
+            }
+        };
+        attach(&mut particles, &mut coincidences);
+        known = true;
+        particles.push(Particle {
+            r#type,
+            energy: number(&tag, "energy", xml::parse_f32)?,
+            intensity: number(&tag, "intensity", xml::parse_f32)?,
+            coincidences: Box::default(),
+        });
+    }
+    attach(&mut particles, &mut coincidences);
+    Ok(particles.into_boxed_slice())
+}
+
+/// Moves collected `coincidences` to the last of `particles`
+fn attach(particles: &mut [Particle], coincidences: &mut Vec<CoincidencePair>) {
+    if let Some(particle) = particles.last_mut()
+        && !coincidences.is_empty()
+    {
+        particle.coincidences = core::mem::take(coincidences).into_boxed_slice();
+    }
+}
+
+/// Maps decay mode, as stored in the database (e.g. `b-`), to [`DecayMode`]
+fn decay_mode(mode: &str) -> DecayMode {
+    match mode.trim_ascii() {
+        "a" => DecayMode::AlphaDecay,
+        "b-" => DecayMode::BetaDecay,
+        "b+" => DecayMode::BetaPlusDecay,
+        "p" => DecayMode::ProtonDecay,
+        "it" => DecayMode::IsometricTransitionDecay,
+        "b-n" => DecayMode::BetaAndNeutronDecay,
+        "b-2n" => DecayMode::BetaAndTwoNeutronDecay,
+        "ec" => DecayMode::ElectronCaptureDecay,
+        "ecp" => DecayMode::ElectronCaptureAndProtonDecay,
+        "eca" => DecayMode::ElectronCaptureAndAlphaDecay,
+        "ec2p" => DecayMode::ElectronCaptureAndTwoProtonDecay,
+        "b-a" => DecayMode::BetaAndAlphaDecay,
+        "b+p" => DecayMode::BetaPlusAndProtonDecay,
+        "b+2p" => DecayMode::BetaPlusAndTwoProtonDecay,
+        "b+3p" => DecayMode::BetaPlusAndThreeProtonDecay,
+        "b+a" => DecayMode::BetaPlusAndAlphaDecay,
+        "2b-" => DecayMode::DoubleBetaDecay,
+        "2ec" => DecayMode::DoubleElectronCaptureDecay,
+        "14c" => DecayMode::Carbon14Decay,
+        "sf" => DecayMode::SpontaneousFissionDecay,
+        "2p" => DecayMode::DoubleProton,
+        _ => DecayMode::UndefinedDecay,
+    }
+}
+
+/// Byte range of `part`, which is a substring of `whole`
+fn subrange(whole: &str, part: &str) -> Range<usize> {
+    let start = part.as_ptr() as usize - whole.as_ptr() as usize;
+    start..start + part.len()
+}
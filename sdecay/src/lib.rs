@@ -95,5 +95,93 @@ pub mod nuclide_spec;
 #[forbid(unsafe_code)]
 pub mod as_cpp_string;
 
+#[forbid(unsafe_code)]
+pub mod efficiency;
+
+#[cfg(feature = "alloc")]
+#[forbid(unsafe_code)]
+pub mod lines;
+
+#[cfg(feature = "alloc")]
+#[forbid(unsafe_code)]
+pub mod coincidence;
+
+#[forbid(unsafe_code)]
+pub mod random;
+
+#[cfg(feature = "alloc")]
+#[forbid(unsafe_code)]
+pub mod event_generator;
+
+#[cfg(feature = "alloc")]
+#[forbid(unsafe_code)]
+pub mod spectrum;
+
+#[cfg(feature = "alloc")]
+#[forbid(unsafe_code)]
+pub mod roi;
+
+#[cfg(feature = "alloc")]
+#[forbid(unsafe_code)]
+pub mod decay_heat;
+
+#[cfg(feature = "alloc")]
+#[forbid(unsafe_code)]
+pub mod dose;
+
+#[cfg(feature = "alloc")]
+#[forbid(unsafe_code)]
+pub mod ordinal;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod solved;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod inventory;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod batch;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod lazy;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod equilibrium;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod weighting;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod reload;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod overlay;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod compression;
+
+#[forbid(unsafe_code)]
+pub mod scan;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+pub mod lazy_database;
+
+#[cfg(feature = "std")]
+#[forbid(unsafe_code)]
+mod parallel;
+
+#[forbid(unsafe_code)]
+mod xml;
+
 #[cfg(test)]
 mod tests;
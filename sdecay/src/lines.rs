@@ -0,0 +1,296 @@
+//! Per-nuclide index of emission lines, built once from the database
+//!
+//! [`LineIndex`] stores, for each nuclide, energies and intensities (per decay of the nuclide) of it's emission lines, sorted by energy. Line rates of a mixture are then simply nuclide activities times these intensities, with no further database traversal.
+//!
+//! Unsafe: no
+
+use alloc::vec::Vec;
+
+use crate::{
+    efficiency::EfficiencyCurve,
+    wrapper::{Nuclide, ProductType, ProductTypeD, SandiaDecayDataBase},
+};
+
+/// Energy of annihilation photons, as used by `SandiaDecay`
+pub const ANNIHILATION_ENERGY: f64 = 510.998_910 * crate::cst::keV;
+
+#[inline]
+pub(crate) fn nuclide_key(nuclide: &Nuclide<'_>) -> usize {
+    core::ptr::from_ref(nuclide) as usize
+}
+
+/// Selection of particles to be included in a [`LineIndex`]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct LineSelection {
+    /// Include $\gamma$ lines
+    pub gammas: bool,
+    /// Include x-ray lines
+    pub xrays: bool,
+    /// Include annihilation photons (two per emitted positron)
+    pub annihilation: bool,
+}
+
+impl LineSelection {
+    /// All the photons, same as [`NuclideMixture::photons`](crate::wrapper::NuclideMixture::photons)
+    pub const PHOTONS: Self = Self {
+        gammas: true,
+        xrays: true,
+        annihilation: true,
+    };
+    /// $\gamma$ lines, same as [`NuclideMixture::gammas`](crate::wrapper::NuclideMixture::gammas) with annihilation photons included
+    pub const GAMMAS: Self = Self {
+        gammas: true,
+        xrays: false,
+        annihilation: true,
+    };
+
+    #[inline]
+    fn includes(self, r#type: ProductType) -> bool {
+        match r#type.d() {
+            ProductTypeD::GammaParticle => self.gammas,
+            ProductTypeD::XrayParticle => self.xrays,
+            _ => false,
+        }
+    }
+}
+
+/// Emission lines of a single nuclide, sorted by energy
+#[derive(Debug, Clone, Copy)]
+pub struct NuclideLines<'i> {
+    /// Line energies, in `SandiaDecay` units
+    pub energies: &'i [f64],
+    /// Number of particles emitted per decay of the nuclide
+    pub intensities: &'i [f64],
+}
+
+impl NuclideLines<'_> {
+    /// Number of lines
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.energies.len()
+    }
+
+    /// Checks if there are no lines
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.energies.is_empty()
+    }
+}
+
+/// Index of emission lines of nuclides, see [module-level docs](self)
+#[derive(Debug, Clone)]
+pub struct LineIndex<'l> {
+    // sorted by address, to allow binary search
+    nuclides: Vec<&'l Nuclide<'l>>,
+    offsets: Vec<usize>,
+    energies: Vec<f64>,
+    intensities: Vec<f64>,
+}
+
+impl<'l> LineIndex<'l> {
+    /// Builds index of all the photons (see [`LineSelection::PHOTONS`]) for every nuclide in the database
+    pub fn photons(database: &'l SandiaDecayDataBase) -> Self {
+        Self::new(database, LineSelection::PHOTONS)
+    }
+
+    /// Builds index of selected lines for every nuclide in the database
+    pub fn new(database: &'l SandiaDecayDataBase, selection: LineSelection) -> Self {
+        Self::from_nuclides(database.nuclides().iter().copied(), selection)
+    }
+
+    /// Builds index of selected lines for specified nuclides only
+    ///
+    /// Nuclides without selected lines are still included (with no lines), duplicates are ignored
+    pub fn from_nuclides(
+        nuclides: impl IntoIterator<Item = &'l Nuclide<'l>>,
+        selection: LineSelection,
+    ) -> Self {
+        let mut nuclides = nuclides.into_iter().collect::<Vec<_>>();
+        nuclides.sort_unstable_by_key(|nuclide| nuclide_key(nuclide));
+        nuclides.dedup_by_key(|nuclide| nuclide_key(nuclide));
+        let mut offsets = Vec::with_capacity(nuclides.len() + 1);
+        let mut energies = Vec::new();
+        let mut intensities = Vec::new();
+        let mut lines = Vec::new();
+        for nuclide in &nuclides {
+            offsets.push(energies.len());
+            lines.clear();
+            collect_lines(nuclide, selection, &mut lines);
+            lines.sort_by(|(a, _), (b, _)| a.total_cmp(b));
+            // merge lines with identical energy
+            let start = energies.len();
+            for (energy, intensity) in lines.drain(..) {
+                if energies.len() > start && energies.last() == Some(&energy) {
+                    *intensities.last_mut().expect("lengths are equal") += intensity;
+                } else {
+                    energies.push(energy);
+                    intensities.push(intensity);
+                }
+            }
+        }
+        offsets.push(energies.len());
+        Self {
+            nuclides,
+            offsets,
+            energies,
+            intensities,
+        }
+    }
+
+    /// Creates a copy of the index with every line intensity multiplied by `weighting` evaluated at line energy
+    ///
+    /// Weighting is evaluated once per line, so queries on the resulting index (e.g. [`ResponseMatrix`](crate::spectrum::ResponseMatrix)) yield weighted rates with no further per-line work. Keep weighted index around for as long as geometry does not change
+    ///
+    /// See `weighting` module (requires `std` feature) for efficiency and attenuation weightings
+    pub fn weighted(&self, weighting: &impl EfficiencyCurve) -> Self {
+        let intensities = self
+            .energies
+            .iter()
+            .zip(&self.intensities)
+            .map(|(&energy, &intensity)| intensity * weighting.efficiency(energy))
+            .collect();
+        Self {
+            nuclides: self.nuclides.clone(),
+            offsets: self.offsets.clone(),
+            energies: self.energies.clone(),
+            intensities,
+        }
+    }
+
+    /// Creates a copy of the index with lines added by `overlay`
+    ///
+    /// Only lines of kinds included in `selection` are added. Lines of nuclides not mentioned by the overlay are copied as-is; nuclides missing from the index are added to it
+    #[cfg(feature = "std")]
+    pub fn patched(&self, overlay: &crate::overlay::Overlay<'l>, selection: LineSelection) -> Self {
+        use crate::overlay::OverlayLineKind;
+
+        let mut nuclides = self.nuclides.clone();
+        nuclides.extend(overlay.nuclides_with_lines());
+        nuclides.sort_unstable_by_key(|nuclide| nuclide_key(nuclide));
+        nuclides.dedup_by_key(|nuclide| nuclide_key(nuclide));
+        let mut offsets = Vec::with_capacity(nuclides.len() + 1);
+        let mut energies = Vec::with_capacity(self.energies.len());
+        let mut intensities = Vec::with_capacity(self.intensities.len());
+        let mut lines = Vec::new();
+        // both lists are sorted by key, so existing nuclides are found by a single forward pass
+        let mut existing = 0;
+        for nuclide in &nuclides {
+            offsets.push(energies.len());
+            let own = if self.nuclides.get(existing).map(|n| nuclide_key(n))
+                == Some(nuclide_key(nuclide))
+            {
+                existing += 1;
+                Some(self.lines_at(existing - 1))
+            } else {
+                None
+            };
+            let added = overlay.lines(nuclide);
+            if added.is_empty() {
+                if let Some(own) = own {
+                    energies.extend_from_slice(own.energies);
+                    intensities.extend_from_slice(own.intensities);
+                }
+                continue;
+            }
+            lines.clear();
+            if let Some(own) = own {
+                lines.extend(
+                    own.energies
+                        .iter()
+                        .copied()
+                        .zip(own.intensities.iter().copied()),
+                );
+            }
+            lines.extend(
+                added
+                    .iter()
+                    .filter(|line| match line.kind {
+                        OverlayLineKind::Gamma => selection.gammas,
+                        OverlayLineKind::Xray => selection.xrays,
+                    })
+                    .map(|line| (line.energy, line.intensity)),
+            );
+            lines.sort_by(|(a, _), (b, _)| a.total_cmp(b));
+            let start = energies.len();
+            for (energy, intensity) in lines.drain(..) {
+                if energies.len() > start && energies.last() == Some(&energy) {
+                    *intensities.last_mut().expect("lengths are equal") += intensity;
+                } else {
+                    energies.push(energy);
+                    intensities.push(intensity);
+                }
+            }
+        }
+        offsets.push(energies.len());
+        Self {
+            nuclides,
+            offsets,
+            energies,
+            intensities,
+        }
+    }
+
+    /// Nuclides in the index
+    ///
+    /// Order is arbitrary, but fixed; it corresponds to [`LineIndex::position`] and [`LineIndex::lines_at`]
+    #[inline]
+    pub fn nuclides(&self) -> &[&'l Nuclide<'l>] {
+        &self.nuclides
+    }
+
+    /// Total number of lines in the index
+    #[inline]
+    pub fn num_lines(&self) -> usize {
+        self.energies.len()
+    }
+
+    /// Position of the `nuclide` in [`LineIndex::nuclides`]
+    ///
+    /// This is a binary search, so consider caching the result
+    pub fn position(&self, nuclide: &Nuclide<'_>) -> Option<usize> {
+        let key = nuclide_key(nuclide);
+        self.nuclides
+            .binary_search_by_key(&key, |nuclide| nuclide_key(nuclide))
+            .ok()
+    }
+
+    /// Lines of the nuclide at `position`
+    ///
+    /// ### Panics
+    /// If `position` is out of bounds of [`LineIndex::nuclides`]
+    #[inline]
+    pub fn lines_at(&self, position: usize) -> NuclideLines<'_> {
+        let range = self.offsets[position]..self.offsets[position + 1];
+        NuclideLines {
+            energies: &self.energies[range.clone()],
+            intensities: &self.intensities[range],
+        }
+    }
+
+    /// Lines of the `nuclide`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide is not in the index
+    #[inline]
+    pub fn lines(&self, nuclide: &Nuclide<'_>) -> Option<NuclideLines<'_>> {
+        self.position(nuclide)
+            .map(|position| self.lines_at(position))
+    }
+}
+
+/// Collects `(energy, intensity per decay)` of selected particles emitted by `nuclide`
+fn collect_lines(nuclide: &Nuclide<'_>, selection: LineSelection, out: &mut Vec<(f64, f64)>) {
+    for transition in &nuclide.decays_to_children {
+        let branch_ratio = f64::from(transition.branch_ratio);
+        for particle in &transition.products {
+            let intensity = branch_ratio * f64::from(particle.intensity);
+            if selection.includes(particle.r#type) {
+                out.push((f64::from(particle.energy), intensity));
+            } else if selection.annihilation
+                && particle.r#type.d() == ProductTypeD::PositronParticle
+            {
+                out.push((ANNIHILATION_ENERGY, 2.0 * intensity));
+            }
+        }
+    }
+}
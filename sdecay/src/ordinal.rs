@@ -0,0 +1,216 @@
+//! Stable database-wide nuclide ordinals, and $O(1)$ nuclide → solution index maps of mixtures
+//!
+//! [`NuclideOrdinals`] assigns every nuclide of a database it's position in [`SandiaDecayDataBase::nuclides`] as an ordinal. `SandiaDecay` keeps nuclides in a single contiguous store; when this is detected, ordinal of a nuclide reference is computed from it's address with plain arithmetic, otherwise a binary search is used.
+//!
+//! [`SolutionIndex`] is built once for a solved mixture and maps ordinals to positions in [`NuclideMixture::decayed_to_nuclides_evolutions`] with a dense array. Together with index-based queries (such as `NuclideMixture::activity_by_solution_index`, requires `std` feature) this replaces per-query nuclide search done by `SandiaDecay`.
+//!
+//! Unsafe: no
+
+use alloc::vec::Vec;
+
+use crate::{
+    lines::nuclide_key,
+    wrapper::{Nuclide, NuclideMixture, SandiaDecayDataBase},
+};
+
+#[derive(Debug, Clone)]
+enum Layout {
+    /// Nuclides are `stride` bytes apart, starting at `base`; `ordinals` maps store slot to ordinal
+    Contiguous {
+        base: usize,
+        stride: usize,
+        ordinals: Vec<u32>,
+    },
+    /// `(address, ordinal)`, sorted by address
+    Sorted { keys: Vec<(usize, u32)> },
+}
+
+/// Database-wide nuclide ordinals, see [module-level docs](self)
+///
+/// Ordinals are stable for a given database file: they only depend on nuclide order in the database
+#[derive(Debug, Clone)]
+pub struct NuclideOrdinals<'l> {
+    nuclides: &'l [&'l Nuclide<'l>],
+    layout: Layout,
+    fingerprint: u64,
+}
+
+impl<'l> NuclideOrdinals<'l> {
+    /// Assigns ordinals to every nuclide in the database
+    pub fn new(database: &'l SandiaDecayDataBase) -> Self {
+        let nuclides = database.nuclides();
+        let layout = Self::contiguous(nuclides).unwrap_or_else(|| {
+            let mut keys = nuclides
+                .iter()
+                .enumerate()
+                .map(|(ordinal, nuclide)| (nuclide_key(nuclide), ordinal as u32))
+                .collect::<Vec<_>>();
+            keys.sort_unstable();
+            Layout::Sorted { keys }
+        });
+        let mut ordinals = Self {
+            nuclides,
+            layout,
+            fingerprint: 0,
+        };
+        ordinals.fingerprint = ordinals.compute_fingerprint();
+        ordinals
+    }
+
+    /// FNV-1a hash of nuclide symbols, half-lives and decay channels, in ordinal order
+    fn compute_fingerprint(&self) -> u64 {
+        const PRIME: u64 = 0x0000_0100_0000_01b3;
+        let mut hash = 0xcbf2_9ce4_8422_2325_u64;
+        let mut feed = |bytes: &[u8]| {
+            for &byte in bytes {
+                hash = (hash ^ u64::from(byte)).wrapping_mul(PRIME);
+            }
+        };
+        feed(&(self.nuclides.len() as u64).to_le_bytes());
+        for nuclide in self.nuclides {
+            feed(nuclide.symbol.as_bytes());
+            feed(&nuclide.half_life.to_bits().to_le_bytes());
+            for transition in &nuclide.decays_to_children {
+                let child = transition
+                    .child
+                    .and_then(|child| self.ordinal(child))
+                    .map_or(u64::MAX, |ordinal| ordinal as u64);
+                feed(&child.to_le_bytes());
+                feed(&transition.branch_ratio.to_bits().to_le_bytes());
+            }
+        }
+        hash
+    }
+
+    /// Fingerprint of the database
+    ///
+    /// Nuclides with equal ordinals in databases with equal fingerprints are (almost certainly) the same, so this can be used to validate data referencing nuclides by ordinals
+    #[inline]
+    pub fn fingerprint(&self) -> u64 {
+        self.fingerprint
+    }
+
+    /// Detects contiguous nuclide store
+    fn contiguous(nuclides: &[&Nuclide<'_>]) -> Option<Layout> {
+        let stride = core::mem::size_of::<Nuclide<'_>>();
+        let base = nuclides.iter().map(|nuclide| nuclide_key(nuclide)).min()?;
+        let mut ordinals = alloc::vec![u32::MAX; nuclides.len()];
+        for (ordinal, nuclide) in nuclides.iter().enumerate() {
+            let offset = nuclide_key(nuclide) - base;
+            if !offset.is_multiple_of(stride) {
+                return None;
+            }
+            let slot = ordinals.get_mut(offset / stride)?;
+            if *slot != u32::MAX {
+                return None;
+            }
+            *slot = ordinal as u32;
+        }
+        Some(Layout::Contiguous {
+            base,
+            stride,
+            ordinals,
+        })
+    }
+
+    /// Number of nuclides (ordinals are `0..len`)
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.nuclides.len()
+    }
+
+    /// Checks if database has no nuclides
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.nuclides.is_empty()
+    }
+
+    /// Checks if ordinal lookup is $O(1)$ address arithmetic (as opposed to binary search)
+    #[inline]
+    pub fn is_contiguous(&self) -> bool {
+        matches!(self.layout, Layout::Contiguous { .. })
+    }
+
+    /// Nuclide with the specified `ordinal`
+    #[inline]
+    pub fn nuclide(&self, ordinal: usize) -> Option<&'l Nuclide<'l>> {
+        self.nuclides.get(ordinal).copied()
+    }
+
+    /// Ordinal of the `nuclide`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide does not belong to the database
+    #[inline]
+    pub fn ordinal(&self, nuclide: &Nuclide<'_>) -> Option<usize> {
+        let key = nuclide_key(nuclide);
+        match &self.layout {
+            Layout::Contiguous {
+                base,
+                stride,
+                ordinals,
+            } => {
+                let offset = key.checked_sub(*base)?;
+                if !offset.is_multiple_of(*stride) {
+                    return None;
+                }
+                ordinals
+                    .get(offset / stride)
+                    .filter(|&&ordinal| ordinal != u32::MAX)
+                    .map(|&ordinal| ordinal as usize)
+            }
+            Layout::Sorted { keys } => keys
+                .binary_search_by_key(&key, |&(key, _)| key)
+                .ok()
+                .map(|position| keys[position].1 as usize),
+        }
+    }
+}
+
+/// Dense map from [`NuclideOrdinals`] to solution nuclide indices of a mixture
+///
+/// Indices correspond to [`NuclideMixture::decayed_to_nuclides_evolutions`] and [`NuclideMixture::solution_nuclide`]. Map is only valid until mixture is modified
+#[derive(Debug, Clone)]
+pub struct SolutionIndex<'o, 'l> {
+    ordinals: &'o NuclideOrdinals<'l>,
+    solution: Vec<u32>,
+}
+
+impl<'o, 'l> SolutionIndex<'o, 'l> {
+    /// Builds map for the solution nuclides of `mixture`
+    ///
+    /// This solves the mixture, if it was not solved yet. Nuclides from other databases are ignored
+    pub fn new(ordinals: &'o NuclideOrdinals<'l>, mixture: &NuclideMixture<'_>) -> Self {
+        let mut solution = alloc::vec![u32::MAX; ordinals.len()];
+        for (index, evolution) in mixture.decayed_to_nuclides_evolutions().iter().enumerate() {
+            if let Some(ordinal) = ordinals.ordinal(evolution.nuclide) {
+                solution[ordinal] = index as u32;
+            }
+        }
+        Self { ordinals, solution }
+    }
+
+    /// Underlying ordinals
+    #[inline]
+    pub fn ordinals(&self) -> &'o NuclideOrdinals<'l> {
+        self.ordinals
+    }
+
+    /// Solution index of the nuclide with specified `ordinal`
+    #[inline]
+    pub fn by_ordinal(&self, ordinal: usize) -> Option<usize> {
+        self.solution
+            .get(ordinal)
+            .filter(|&&index| index != u32::MAX)
+            .map(|&index| index as usize)
+    }
+
+    /// Solution index of the `nuclide`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide is not among the solution nuclides
+    #[inline]
+    pub fn get(&self, nuclide: &Nuclide<'_>) -> Option<usize> {
+        self.by_ordinal(self.ordinals.ordinal(nuclide)?)
+    }
+}
@@ -0,0 +1,288 @@
+//! Database overlays: small corrections, applied on top of an initialized database
+//!
+//! `SandiaDecay` database is immutable once initialized, and it's nuclides are borrowed all over the place. [`Overlay`] keeps corrections (half-lives and additional photon lines) aside, referencing only the affected nuclides; the database itself is never touched. Overlay is consumed by
+//! - [`Overlay::solve`] - solves mixture evolution with corrected half-lives
+//! - [`LineIndex::patched`](crate::lines::LineIndex::patched) - adds lines to a line index
+//! - [`ChainCache::apply_overlay`](crate::inventory::ChainCache::apply_overlay) - re-solves only cached chains with corrected nuclides
+//!
+//! Overlays are built either with [`Overlay::set_half_life`] and [`Overlay::add_line`], or parsed from a small XML patch with [`Overlay::parse`]; either way, cost depends on patch size only.
+//!
+//! ### Patch format
+//! ```xml
+//! <patch>
+//!   <!-- half-life in seconds -->
+//!   <nuclide symbol="Co60" halfLife="1.66344e8"/>
+//!   <!-- energy in keV, intensity per decay of the nuclide -->
+//!   <gamma nuclide="Cs137" energy="661.657" intensity="0.851"/>
+//!   <xray nuclide="Cs137" energy="32.194" intensity="0.0364"/>
+//! </patch>
+//! ```
+//!
+//! Unsafe: no
+
+use alloc::{
+    collections::{BTreeMap, BTreeSet},
+    string::{String, ToString},
+    vec::Vec,
+};
+
+use crate::{
+    cst::{keV, second},
+    equilibrium::EquilibriumFolding,
+    lines::nuclide_key,
+    nuclide_spec::NuclideSpec,
+    solved::SolvedMixture,
+    wrapper::{Nuclide, SandiaDecayDataBase},
+    xml,
+};
+
+/// Error returned by [`Overlay::parse`] and [`ChainCache::apply_overlay`](crate::inventory::ChainCache::apply_overlay)
+#[derive(Debug, Error)]
+pub enum OverlayError {
+    /// Patch is not well-formed
+    #[error("Unterminated markup at byte {0}")]
+    Syntax(usize),
+    /// Patch references nuclide not present in the database
+    #[error("Unknown nuclide {0:?}")]
+    UnknownNuclide(String),
+    /// Required attribute is missing
+    #[error("Element <{element}> misses attribute {attribute:?}")]
+    MissingAttribute {
+        /// Element name
+        element: String,
+        /// Attribute name
+        attribute: &'static str,
+    },
+    /// Attribute value is not a valid number
+    #[error("Attribute {attribute:?} has invalid value {value:?}")]
+    BadNumber {
+        /// Attribute name
+        attribute: &'static str,
+        /// Attribute value
+        value: String,
+    },
+    /// Half-life is not positive
+    #[error("Half-life of {0:?} should be positive")]
+    BadHalfLife(String),
+    /// Decay chain of the nuclide is degenerate with corrected half-lives, see [`Overlay::solve`]
+    #[error("Decay chain of {0:?} is degenerate with corrected half-lives")]
+    DegenerateChain(String),
+}
+
+/// Kind of added line
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum OverlayLineKind {
+    /// $\gamma$ line
+    Gamma,
+    /// X-ray line
+    Xray,
+}
+
+/// Line, added by [`Overlay`]
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct OverlayLine {
+    /// Line kind
+    pub kind: OverlayLineKind,
+    /// Energy, in `SandiaDecay` units
+    pub energy: f64,
+    /// Number of particles emitted per decay of the nuclide
+    pub intensity: f64,
+}
+
+/// Corrections on top of an initialized database, see [module-level docs](self)
+#[derive(Debug, Clone, Default)]
+pub struct Overlay<'l> {
+    /// Corrected half-lives, by nuclide key
+    half_lives: BTreeMap<usize, (&'l Nuclide<'l>, f64)>,
+    /// Added lines, by nuclide key
+    lines: BTreeMap<usize, (&'l Nuclide<'l>, Vec<OverlayLine>)>,
+}
+
+impl<'l> Overlay<'l> {
+    /// Creates empty overlay
+    #[inline]
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Parses XML patch (see [module-level docs](self) for format), resolving nuclides in `database`
+    ///
+    /// Unknown elements are ignored
+    ///
+    /// ### Errors
+    /// See [`OverlayError`] variants
+    pub fn parse(database: &'l SandiaDecayDataBase, patch: &str) -> Result<Self, OverlayError> {
+        let mut overlay = Self::new();
+        for tag in xml::tags(patch) {
+            let tag = tag.map_err(OverlayError::Syntax)?;
+            let kind = match tag.name {
+                "nuclide" => None,
+                "gamma" => Some(OverlayLineKind::Gamma),
+                "xray" => Some(OverlayLineKind::Xray),
+                _ => continue,
+            };
+            let attribute = |attribute: &'static str| {
+                tag.attribute(attribute)
+                    .ok_or_else(|| OverlayError::MissingAttribute {
+                        element: tag.name.to_string(),
+                        attribute,
+                    })
+            };
+            let number = |name: &'static str| {
+                let value = attribute(name)?;
+                xml::parse_f64(value).ok_or_else(|| OverlayError::BadNumber {
+                    attribute: name,
+                    value: value.to_string(),
+                })
+            };
+            let resolve = |symbol: &str| {
+                symbol
+                    .get_nuclide(database)
+                    .ok_or_else(|| OverlayError::UnknownNuclide(symbol.to_string()))
+            };
+            match kind {
+                None => {
+                    let symbol = attribute("symbol")?;
+                    let half_life = number("halfLife")? * second;
+                    if half_life.is_nan() || half_life <= 0.0 {
+                        return Err(OverlayError::BadHalfLife(symbol.to_string()));
+                    }
+                    overlay.set_half_life(resolve(symbol)?, half_life);
+                }
+                Some(kind) => {
+                    let nuclide = resolve(attribute("nuclide")?)?;
+                    overlay.add_line(
+                        nuclide,
+                        OverlayLine {
+                            kind,
+                            energy: number("energy")? * keV,
+                            intensity: number("intensity")?,
+                        },
+                    );
+                }
+            }
+        }
+        Ok(overlay)
+    }
+
+    /// Sets corrected half-life of the `nuclide`
+    ///
+    /// ### Panics
+    /// If `half_life` is not positive
+    pub fn set_half_life(&mut self, nuclide: &'l Nuclide<'l>, half_life: f64) {
+        assert!(half_life > 0.0, "half-life should be positive");
+        self.half_lives
+            .insert(nuclide_key(nuclide), (nuclide, half_life));
+    }
+
+    /// Adds photon line to the `nuclide`
+    pub fn add_line(&mut self, nuclide: &'l Nuclide<'l>, line: OverlayLine) {
+        self.lines
+            .entry(nuclide_key(nuclide))
+            .or_insert_with(|| (nuclide, Vec::new()))
+            .1
+            .push(line);
+    }
+
+    /// Adds corrections of `other` overlay, overriding half-lives set in both
+    pub fn extend(&mut self, other: &Self) {
+        self.half_lives
+            .extend(other.half_lives.iter().map(|(&key, &value)| (key, value)));
+        for (&key, (nuclide, lines)) in &other.lines {
+            self.lines
+                .entry(key)
+                .or_insert_with(|| (nuclide, Vec::new()))
+                .1
+                .extend_from_slice(lines);
+        }
+    }
+
+    /// Checks if overlay has no corrections
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.half_lives.is_empty() && self.lines.is_empty()
+    }
+
+    /// Nuclides with corrected half-lives
+    pub fn corrected_nuclides(&self) -> impl Iterator<Item = &'l Nuclide<'l>> + '_ {
+        self.half_lives.values().map(|&(nuclide, _)| nuclide)
+    }
+
+    /// Nuclides with added lines
+    pub fn nuclides_with_lines(&self) -> impl Iterator<Item = &'l Nuclide<'l>> + '_ {
+        self.lines.values().map(|&(nuclide, _)| nuclide)
+    }
+
+    /// Half-life of the `nuclide`, with overlay applied
+    #[inline]
+    pub fn half_life(&self, nuclide: &Nuclide<'_>) -> f64 {
+        self.half_lives
+            .get(&nuclide_key(nuclide))
+            .map_or(nuclide.half_life, |&(_, half_life)| half_life)
+    }
+
+    /// Decay constant of the `nuclide`, with overlay applied
+    #[inline]
+    pub fn decay_constant(&self, nuclide: &Nuclide<'_>) -> f64 {
+        match self.half_lives.get(&nuclide_key(nuclide)) {
+            Some(&(_, half_life)) => core::f64::consts::LN_2 / half_life,
+            None => nuclide.decay_constant(),
+        }
+    }
+
+    /// Lines, added to the `nuclide`
+    #[inline]
+    pub fn lines(&self, nuclide: &Nuclide<'_>) -> &[OverlayLine] {
+        self.lines
+            .get(&nuclide_key(nuclide))
+            .map_or(&[], |(_, lines)| lines.as_slice())
+    }
+
+    /// Checks if evolution of a mixture with these `nuclides` is affected by the overlay, i.e. if any of them has corrected half-life
+    pub fn affects_solution<'n>(
+        &self,
+        nuclides: impl IntoIterator<Item = &'n Nuclide<'n>>,
+    ) -> bool {
+        !self.half_lives.is_empty()
+            && nuclides
+                .into_iter()
+                .any(|nuclide| self.half_lives.contains_key(&nuclide_key(nuclide)))
+    }
+
+    /// Checks if decay chain of the `parent` is affected by the overlay
+    pub fn affects_chain(&self, parent: &Nuclide<'_>) -> bool {
+        if self.half_lives.is_empty() {
+            return false;
+        }
+        let mut visited = BTreeSet::new();
+        let mut stack = alloc::vec![parent];
+        while let Some(nuclide) = stack.pop() {
+            let key = nuclide_key(nuclide);
+            if !visited.insert(key) {
+                continue;
+            }
+            if self.half_lives.contains_key(&key) {
+                return true;
+            }
+            stack.extend(
+                nuclide
+                    .decays_to_children
+                    .iter()
+                    .filter_map(|transition| transition.child),
+            );
+        }
+        false
+    }
+
+    /// Solves evolution of mixture with `initial` nuclides and their numbers of atoms, using corrected half-lives
+    ///
+    /// Solution is obtained by propagation along the decay graph (see [`crate::equilibrium`]), with nothing folded
+    ///
+    /// ### Returns
+    /// [`Option::None`], if solution is degenerate, i.e. corrected half-life of some nuclide matches half-life of it's ancestor or descendant. Evolution is not a sum of exponents then
+    pub fn solve(&self, initial: &[(&'l Nuclide<'l>, f64)]) -> Option<SolvedMixture<'l>> {
+        EquilibriumFolding::new(0.0)
+            .solve_with(initial, &|nuclide| self.decay_constant(nuclide))
+            .map(|solved| solved.into_kept())
+    }
+}
@@ -0,0 +1,83 @@
+//! Splitting work between scoped threads
+//!
+//! Every `*_parallel` function of this crate splits it's items (nuclides, mixtures, events, etc) into contiguous chunks, with sizes differing by at most one (earlier chunks are larger), one chunk per thread. Results are always combined in chunk order, so they never depend on thread scheduling. A single chunk is processed on the calling thread.
+//!
+//! Unsafe: no
+
+use core::ops::Range;
+
+use alloc::vec::Vec;
+
+/// Splits `items` into at most `threads` contiguous non-empty ranges
+///
+/// Zero `threads` are treated as one; zero `items` produce no ranges
+pub(crate) fn ranges(items: usize, threads: usize) -> impl ExactSizeIterator<Item = Range<usize>> {
+    let chunks = threads.max(1).min(items);
+    let (base, remainder) = if chunks == 0 {
+        (0, 0)
+    } else {
+        (items / chunks, items % chunks)
+    };
+    (0..chunks).map(move |chunk| {
+        let start = chunk * base + chunk.min(remainder);
+        start..start + base + usize::from(chunk < remainder)
+    })
+}
+
+/// Evaluates `f` for each of [`ranges`]`(items, threads)` on a separate thread
+///
+/// `f` receives chunk index and range of items
+///
+/// ### Returns
+/// Results in range order
+pub(crate) fn map<R: Send>(
+    items: usize,
+    threads: usize,
+    f: impl Fn(usize, Range<usize>) -> R + Sync,
+) -> Vec<R> {
+    let ranges = ranges(items, threads);
+    if ranges.len() <= 1 {
+        return ranges.map(|range| f(0, range)).collect();
+    }
+    let f = &f;
+    std::thread::scope(|scope| {
+        let handles = ranges
+            .enumerate()
+            .map(|(chunk, range)| scope.spawn(move || f(chunk, range)))
+            .collect::<Vec<_>>();
+        handles
+            .into_iter()
+            .map(|handle| handle.join().expect("worker threads should not panic"))
+            .collect()
+    })
+}
+
+/// Splits `out` into rows of `stride` elements, and calls `f` for rows in each of [`ranges`] on a separate thread
+///
+/// `f` receives range of row indices and the corresponding part of `out`
+///
+/// ### Panics
+/// If `out` does not consist of whole rows
+pub(crate) fn for_each_mut<T: Send>(
+    out: &mut [T],
+    stride: usize,
+    threads: usize,
+    f: impl Fn(Range<usize>, &mut [T]) + Sync,
+) {
+    let stride = stride.max(1);
+    assert_eq!(out.len() % stride, 0, "output should consist of whole rows");
+    let ranges = ranges(out.len() / stride, threads);
+    if ranges.len() <= 1 {
+        ranges.for_each(|range| f(range, out));
+        return;
+    }
+    let f = &f;
+    std::thread::scope(|scope| {
+        let mut rest = out;
+        for range in ranges {
+            let (chunk, tail) = rest.split_at_mut(range.len() * stride);
+            rest = tail;
+            scope.spawn(move || f(range, chunk));
+        }
+    });
+}
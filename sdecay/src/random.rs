@@ -0,0 +1,355 @@
+//! Random sampling primitives used by Monte Carlo facilities of this crate
+//!
+//! - [`Rng`] is a small, fast, seedable `xoshiro256++` generator. Independent streams (e.g. one per thread) are obtained with [`Rng::stream`]
+//! - [`AliasTable`] is a Walker (Vose) alias table, allowing $O(1)$ sampling from discrete distribution
+//! - [`Poisson`] samples Poisson-distributed counts (requires `std`, for floating point functions)
+//!
+//! Unsafe: no
+
+#[cfg(feature = "alloc")]
+use alloc::vec::Vec;
+
+/// `xoshiro256++` pseudo-random number generator
+///
+/// This generator is **NOT** cryptographically secure. It's intended for simulations, where speed and reproducibility are of concern
+///
+/// ### Example
+/// ```rust
+/// # use sdecay::random::Rng;
+/// let mut a = Rng::new(42);
+/// let mut b = Rng::new(42);
+/// assert_eq!(a.next_u64(), b.next_u64());
+/// let x = a.next_f64();
+/// assert!((0.0..1.0).contains(&x));
+/// ```
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Rng {
+    state: [u64; 4],
+}
+
+#[inline]
+fn splitmix64(state: &mut u64) -> u64 {
+    *state = state.wrapping_add(0x9E37_79B9_7F4A_7C15);
+    let mut z = *state;
+    z = (z ^ (z >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+    z = (z ^ (z >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+    z ^ (z >> 31)
+}
+
+impl Rng {
+    /// Creates generator from a `seed`
+    ///
+    /// Generator state is expanded from the seed with `splitmix64`, so any seed (including zero) is fine
+    pub fn new(seed: u64) -> Self {
+        let mut sm = seed;
+        let state = [
+            splitmix64(&mut sm),
+            splitmix64(&mut sm),
+            splitmix64(&mut sm),
+            splitmix64(&mut sm),
+        ];
+        Self { state }
+    }
+
+    /// Creates generator for an independent stream number `stream`, derived from a `seed`
+    ///
+    /// Streams are separated by $2^{128}$ steps of the generator (via [`Rng::jump`]), so they never overlap in practice. Intended use is one stream per thread
+    pub fn stream(seed: u64, stream: u64) -> Self {
+        let mut rng = Self::new(seed);
+        for _ in 0..stream {
+            rng.jump();
+        }
+        rng
+    }
+
+    /// Creates generator for an item number `index` (e.g. a realization of a random process), derived from a `seed`
+    ///
+    /// Unlike [`Rng::stream`], this is $O(1)$, so it is suitable for seeding every item of a large batch separately. That way, results do not depend on how items are distributed between threads
+    pub fn for_index(seed: u64, index: u64) -> Self {
+        let mut sm = seed;
+        let base = splitmix64(&mut sm);
+        Self::new(base ^ index.wrapping_mul(0xD1B5_4A32_D192_ED03))
+    }
+
+    /// Generates next 64 random bits
+    #[inline]
+    pub fn next_u64(&mut self) -> u64 {
+        let [s0, s1, s2, s3] = &mut self.state;
+        let result = s0.wrapping_add(*s3).rotate_left(23).wrapping_add(*s0);
+        let t = *s1 << 17;
+        *s2 ^= *s0;
+        *s3 ^= *s1;
+        *s1 ^= *s2;
+        *s0 ^= *s3;
+        *s2 ^= t;
+        *s3 = s3.rotate_left(45);
+        result
+    }
+
+    /// Generates uniformly distributed number in $[0; 1)$
+    #[inline]
+    pub fn next_f64(&mut self) -> f64 {
+        // 53 random bits of mantissa
+        (self.next_u64() >> 11) as f64 * (1.0 / (1u64 << 53) as f64)
+    }
+
+    /// Advances the generator by $2^{128}$ steps
+    pub fn jump(&mut self) {
+        const JUMP: [u64; 4] = [
+            0x180E_C6D3_3CFD_0ABA,
+            0xD5A6_1266_F0C9_392C,
+            0xA958_2618_E03F_C9AA,
+            0x39AB_DC45_29B1_661C,
+        ];
+        let mut jumped = [0u64; 4];
+        for word in JUMP {
+            for bit in 0..64 {
+                if word & (1u64 << bit) != 0 {
+                    for (j, s) in jumped.iter_mut().zip(&self.state) {
+                        *j ^= s;
+                    }
+                }
+                self.next_u64();
+            }
+        }
+        self.state = jumped;
+    }
+}
+
+/// Walker alias table over a discrete distribution
+///
+/// Construction is $O(n)$ (Vose's algorithm), sampling is $O(1)$ and consumes a single [`Rng::next_f64`] call
+///
+/// ### Example
+/// ```rust
+/// # use sdecay::random::{AliasTable, Rng};
+/// let table = AliasTable::new(&[1.0, 0.0, 3.0]).unwrap();
+/// let mut rng = Rng::new(0);
+/// for _ in 0..100 {
+///     assert_ne!(table.sample(&mut rng), 1);
+/// }
+/// ```
+#[cfg(feature = "alloc")]
+#[derive(Debug, Clone)]
+pub struct AliasTable {
+    probability: Vec<f64>,
+    alias: Vec<u32>,
+    total_weight: f64,
+}
+
+#[cfg(feature = "alloc")]
+impl AliasTable {
+    /// Creates alias table for distribution with given (not necessarily normalized) `weights`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if `weights` are empty, have non-positive sum, or contain negative or non-finite values
+    pub fn new(weights: &[f64]) -> Option<Self> {
+        let n = weights.len();
+        if n == 0 || u32::try_from(n).is_err() {
+            return None;
+        }
+        if weights.iter().any(|w| !w.is_finite() || *w < 0.0) {
+            return None;
+        }
+        let total_weight: f64 = weights.iter().sum();
+        if total_weight <= 0.0 || !total_weight.is_finite() {
+            return None;
+        }
+        let scale = n as f64 / total_weight;
+        let mut probability = weights.iter().map(|w| w * scale).collect::<Vec<_>>();
+        let mut alias = (0..n as u32).collect::<Vec<_>>();
+        let (mut small, mut large): (Vec<u32>, Vec<u32>) =
+            (0..n as u32).partition(|&i| probability[i as usize] < 1.0);
+        while let (Some(&s), Some(&l)) = (small.last(), large.last()) {
+            small.pop();
+            alias[s as usize] = l;
+            probability[l as usize] -= 1.0 - probability[s as usize];
+            if probability[l as usize] < 1.0 {
+                large.pop();
+                small.push(l);
+            }
+        }
+        // leftovers are equal to 1 up to rounding errors
+        for i in small.into_iter().chain(large) {
+            probability[i as usize] = 1.0;
+        }
+        Some(Self {
+            probability,
+            alias,
+            total_weight,
+        })
+    }
+
+    /// Number of outcomes in the distribution
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.probability.len()
+    }
+
+    /// Checks if table contains no outcomes (never true for a constructed table)
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.probability.is_empty()
+    }
+
+    /// Sum of weights table was constructed from
+    #[inline]
+    pub fn total_weight(&self) -> f64 {
+        self.total_weight
+    }
+
+    /// Samples an outcome index
+    #[inline]
+    pub fn sample(&self, rng: &mut Rng) -> usize {
+        let x = rng.next_f64() * self.probability.len() as f64;
+        // `x` is never equal to length, but rounding might produce that
+        let i = (x as usize).min(self.probability.len() - 1);
+        if x - (i as f64) < self.probability[i] {
+            i
+        } else {
+            self.alias[i] as usize
+        }
+    }
+}
+
+/// $\ln(k!)$, exact for small `k` and Stirling series otherwise
+#[cfg(feature = "std")]
+fn ln_factorial(k: f64) -> f64 {
+    const TABLE: [f64; 10] = [
+        0.0,
+        0.0,
+        core::f64::consts::LN_2,
+        1.791_759_469_228_055,
+        3.178_053_830_347_146,
+        4.787_491_742_782_046,
+        6.579_251_212_010_101,
+        8.525_161_361_065_415,
+        10.604_602_902_745_25,
+        12.801_827_480_081_469,
+    ];
+    if k < 10.0 {
+        return TABLE[k as usize];
+    }
+    let x = k + 1.0;
+    let x2 = x * x;
+    (x - 0.5) * x.ln() - x
+        + 0.5 * (2.0 * core::f64::consts::PI).ln()
+        + (1.0 / 12.0 - (1.0 / 360.0 - 1.0 / (1260.0 * x2)) / x2) / x
+}
+
+/// Poisson distribution sampler with precomputed constants
+///
+/// Small means ($< 10$) are sampled by CDF inversion, larger ones by Hörmann's transformed rejection with squeeze (PTRS). Both cost $O(1)$ random numbers on average, and construction cost is paid once, which is beneficial when sampling many times from the same mean (e.g. a spectrum bin over many realizations)
+///
+/// ### Example
+/// ```rust
+/// # use sdecay::random::{Poisson, Rng};
+/// let poisson = Poisson::new(3.5);
+/// let mut rng = Rng::new(0);
+/// let mean = (0..10_000).map(|_| poisson.sample(&mut rng)).sum::<u64>() as f64 / 10_000.0;
+/// assert!((mean - 3.5).abs() < 0.1);
+/// ```
+#[cfg(feature = "std")]
+#[derive(Debug, Clone, Copy)]
+pub struct Poisson(PoissonKind);
+
+#[cfg(feature = "std")]
+#[derive(Debug, Clone, Copy)]
+enum PoissonKind {
+    Zero,
+    Inversion {
+        mean: f64,
+        exp_neg_mean: f64,
+    },
+    Ptrs {
+        mean: f64,
+        ln_mean: f64,
+        a: f64,
+        b: f64,
+        ln_inv_alpha: f64,
+        v_r: f64,
+    },
+}
+
+#[cfg(feature = "std")]
+impl Poisson {
+    /// Creates sampler for Poisson distribution with `mean`
+    ///
+    /// Non-positive and non-finite means produce sampler always returning zero
+    pub fn new(mean: f64) -> Self {
+        if !(mean > 0.0 && mean.is_finite()) {
+            return Self(PoissonKind::Zero);
+        }
+        if mean < 10.0 {
+            return Self(PoissonKind::Inversion {
+                mean,
+                exp_neg_mean: (-mean).exp(),
+            });
+        }
+        let b = 0.931 + 2.53 * mean.sqrt();
+        let a = -0.059 + 0.024_83 * b;
+        let inv_alpha = 1.1239 + 1.1328 / (b - 3.4);
+        let v_r = 0.9277 - 3.6224 / (b - 2.0);
+        Self(PoissonKind::Ptrs {
+            mean,
+            ln_mean: mean.ln(),
+            a,
+            b,
+            ln_inv_alpha: inv_alpha.ln(),
+            v_r,
+        })
+    }
+
+    /// Mean of the distribution
+    pub fn mean(&self) -> f64 {
+        match self.0 {
+            PoissonKind::Zero => 0.0,
+            PoissonKind::Inversion { mean, .. } | PoissonKind::Ptrs { mean, .. } => mean,
+        }
+    }
+
+    /// Draws a sample
+    #[inline]
+    pub fn sample(&self, rng: &mut Rng) -> u64 {
+        match self.0 {
+            PoissonKind::Zero => 0,
+            PoissonKind::Inversion { mean, exp_neg_mean } => {
+                let u = rng.next_f64();
+                let mut k = 0u64;
+                let mut p = exp_neg_mean;
+                let mut cdf = p;
+                // cdf approaches 1 very quickly for small means; cap guards rounding
+                while u > cdf && k < 1000 {
+                    k += 1;
+                    p *= mean / k as f64;
+                    cdf += p;
+                }
+                k
+            }
+            PoissonKind::Ptrs {
+                mean,
+                ln_mean,
+                a,
+                b,
+                ln_inv_alpha,
+                v_r,
+            } => loop {
+                let u = rng.next_f64() - 0.5;
+                let v = rng.next_f64();
+                let us = 0.5 - u.abs();
+                let k = ((2.0 * a / us + b) * u + mean + 0.43).floor();
+                if us >= 0.07 && v <= v_r {
+                    return k as u64;
+                }
+                if k < 0.0 || (us < 0.013 && v > us) {
+                    continue;
+                }
+                if v.ln() + ln_inv_alpha - (a / (us * us) + b).ln()
+                    <= -mean + k * ln_mean - ln_factorial(k)
+                {
+                    return k as u64;
+                }
+            },
+        }
+    }
+}
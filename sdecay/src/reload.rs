@@ -0,0 +1,193 @@
+//! Hot-reloadable database, replaced under live readers
+//!
+//! [`GenericDatabase::reset`](crate::database::GenericDatabase::reset) requires exclusive access, and invalidates every [`Nuclide`](crate::wrapper::Nuclide) borrowed from the database. [`ReloadableDatabase`] follows read-copy-update scheme instead: new database is initialized aside (possibly on a background thread, while readers go on), and then swapped in with a single pointer store. Readers hold reference-counted [`SharedDatabase`] snapshots; the old database is freed once the last reader drops it's snapshot, so borrowed nuclides stay valid for as long as the snapshot lives.
+//!
+//! [`DatabaseReader`] caches a snapshot, and only checks an atomic generation counter on each access; this never blocks. Lock is taken only to pick up a new snapshot after a reload, so a refresh **can block**: lock is writer-preferring on some platforms, so refreshing reader waits for a pending swap. Both readers and writers hold the lock only for a reference count update or a pointer swap, though, so a reader never waits for database initialization, which happens outside of the lock.
+//!
+//! Releasing an old database might run it's (costly) destructor, if that was the last snapshot. Readers never do that on their path: replaced snapshots are sent to a retire queue (a non-blocking channel send) instead, and are dropped by writers, on every reload, or by [`ReloadableDatabase::reclaim`].
+//!
+//! Unsafe: no
+
+use std::{
+    sync::{
+        Arc, Mutex, PoisonError, RwLock,
+        atomic::{AtomicU64, Ordering},
+        mpsc::{self, Receiver, Sender},
+    },
+    thread::JoinHandle,
+};
+
+use crate::{as_cpp_string::AsCppString, database::SharedDatabase, wrapper::CppException};
+
+/// Database, that can be atomically replaced under live readers, see [module-level docs](self)
+///
+/// ### Example
+/// ```rust,no_run
+/// # use sdecay::{database::SharedDatabase, nuclide, reload::ReloadableDatabase};
+/// let database = ReloadableDatabase::new(SharedDatabase::from_path("database.xml").unwrap());
+/// let mut reader = database.reader();
+/// let snapshot = reader.get().clone();
+/// let co60 = snapshot.nuclide(nuclide!(Co - 60));
+/// // ... meanwhile, in another thread
+/// database.reload_path("corrected.xml").unwrap();
+/// // `co60` is still valid, since `snapshot` holds the old database
+/// let _ = co60.half_life;
+/// // next access picks up the new database
+/// let _ = reader.get().nuclide(nuclide!(Co - 60));
+/// ```
+#[derive(Debug)]
+pub struct ReloadableDatabase {
+    current: RwLock<SharedDatabase>,
+    generation: AtomicU64,
+    /// Snapshots released by readers, see [module-level docs](self)
+    retire: Sender<SharedDatabase>,
+    retired: Mutex<Receiver<SharedDatabase>>,
+}
+
+impl ReloadableDatabase {
+    /// Wraps initialized `database`
+    pub fn new(database: SharedDatabase) -> Self {
+        let (retire, retired) = mpsc::channel();
+        Self {
+            current: RwLock::new(database),
+            generation: AtomicU64::new(0),
+            retire,
+            retired: Mutex::new(retired),
+        }
+    }
+
+    /// Drops snapshots, released by readers since the last call (or reload)
+    ///
+    /// Reloads call this automatically; call it explicitly (e.g. from a maintenance thread) to free old databases sooner, if reloads are rare
+    ///
+    /// ### Returns
+    /// Number of dropped snapshots
+    pub fn reclaim(&self) -> usize {
+        let retired = self.retired.lock().unwrap_or_else(PoisonError::into_inner);
+        retired.try_iter().count()
+    }
+
+    /// Number of reloads so far
+    #[inline]
+    pub fn generation(&self) -> u64 {
+        self.generation.load(Ordering::Acquire)
+    }
+
+    /// Snapshot of the current database
+    ///
+    /// Snapshot is not affected by later reloads
+    pub fn load(&self) -> SharedDatabase {
+        self.current
+            .read()
+            .unwrap_or_else(PoisonError::into_inner)
+            .clone()
+    }
+
+    /// Creates a reader, caching snapshot of the current database
+    pub fn reader(&self) -> DatabaseReader<'_> {
+        // generation is read first: a reload in between only causes a spurious refresh
+        let generation = self.generation();
+        DatabaseReader {
+            source: self,
+            generation,
+            snapshot: self.load(),
+        }
+    }
+
+    /// Atomically replaces current database with already initialized `database`
+    ///
+    /// ### Returns
+    /// Previous database. It's freed once this and all the readers' snapshots are dropped
+    pub fn replace(&self, database: SharedDatabase) -> SharedDatabase {
+        self.swap(database).0
+    }
+
+    /// Sends snapshot to the retire queue
+    fn retire(&self, snapshot: SharedDatabase) {
+        // receiver lives as long as `self`, so this only fails during drop, when dropping right away is fine
+        drop(self.retire.send(snapshot));
+    }
+
+    /// Replaces current database, returning previous one and generation of the new one
+    ///
+    /// Generation is bumped under the lock, so it's unique to this swap even with concurrent reloads
+    fn swap(&self, database: SharedDatabase) -> (SharedDatabase, u64) {
+        let mut current = self.current.write().unwrap_or_else(PoisonError::into_inner);
+        let previous = core::mem::replace(&mut *current, database);
+        let generation = self.generation.fetch_add(1, Ordering::Release) + 1;
+        (previous, generation)
+    }
+
+    /// Initializes new database from `path`, and replaces current one with it
+    ///
+    /// Initialization happens outside of any lock; readers continue to use current database meanwhile
+    ///
+    /// ### Returns
+    /// [`ReloadableDatabase::generation`] this reload has set, even if other reloads follow right away
+    ///
+    /// ### Errors
+    /// Exception, thrown by `SandiaDecay` during initialization. Current database is left intact
+    pub fn reload_path(&self, path: impl AsCppString) -> Result<u64, CppException> {
+        let database = SharedDatabase::from_path(path)?;
+        let (previous, generation) = self.swap(database);
+        drop(previous);
+        self.reclaim();
+        Ok(generation)
+    }
+
+    /// Same as [`ReloadableDatabase::reload_path`], but initializes new database from `bytes`
+    ///
+    /// ### Errors
+    /// Exception, thrown by `SandiaDecay` during initialization. Current database is left intact
+    pub fn reload_bytes(&self, bytes: impl AsRef<[u8]>) -> Result<u64, CppException> {
+        let database = SharedDatabase::from_bytes(bytes)?;
+        let (previous, generation) = self.swap(database);
+        drop(previous);
+        self.reclaim();
+        Ok(generation)
+    }
+
+    /// Spawns a thread, performing [`ReloadableDatabase::reload_path`]
+    pub fn reload_in_background<P: AsCppString + Send + 'static>(
+        self: &Arc<Self>,
+        path: P,
+    ) -> JoinHandle<Result<u64, CppException>> {
+        let database = Arc::clone(self);
+        std::thread::spawn(move || database.reload_path(path))
+    }
+}
+
+/// Reader of a [`ReloadableDatabase`], caching a snapshot of it
+#[derive(Debug)]
+pub struct DatabaseReader<'r> {
+    source: &'r ReloadableDatabase,
+    generation: u64,
+    snapshot: SharedDatabase,
+}
+
+impl DatabaseReader<'_> {
+    /// Current database
+    ///
+    /// If database was reloaded since last call, cached snapshot is refreshed; this can block (see [module-level docs](self)). Old snapshot is sent to the retire queue, and is never dropped here. Otherwise, this is a single atomic load
+    pub fn get(&mut self) -> &SharedDatabase {
+        let generation = self.source.generation();
+        if generation != self.generation {
+            self.generation = generation;
+            let previous = core::mem::replace(&mut self.snapshot, self.source.load());
+            self.source.retire(previous);
+        }
+        &self.snapshot
+    }
+
+    /// Cached snapshot, without checking for reloads
+    #[inline]
+    pub fn snapshot(&self) -> &SharedDatabase {
+        &self.snapshot
+    }
+
+    /// Checks if database was reloaded since last [`DatabaseReader::get`]
+    #[inline]
+    pub fn is_stale(&self) -> bool {
+        self.source.generation() != self.generation
+    }
+}
@@ -0,0 +1,193 @@
+//! Summed emission rates in energy windows (regions of interest), computed without materializing mixture lines
+//!
+//! [`RoiIndex`] is built once from a [`LineIndex`] and a set of energy windows. For each nuclide it stores the total intensity of it's lines falling into each window; since lines are sorted by energy, only lines inside the windows are ever touched. ROI rates of a mixture are then a short sum over the nuclides of the mixture.
+//!
+//! Unsafe: no
+
+use alloc::vec::Vec;
+use core::ops::Range;
+
+use crate::{
+    lines::LineIndex,
+    wrapper::{Nuclide, NuclideActivityPair, NuclideMixture},
+};
+
+/// Sparse nuclide × window matrix of emission intensities, see [module-level docs](self)
+///
+/// Window $[E_{min}; E_{max})$ includes lines with $E_{min} \le E < E_{max}$. Windows may overlap
+///
+/// ### Example
+/// ```rust,no_run
+/// # use sdecay::{database::Database, nuclide, cst::{keV, Ci}, lines::LineIndex, roi::RoiIndex};
+/// # let database = Database::from_path("database.xml").unwrap();
+/// let lines = LineIndex::photons(&database);
+/// let roi = RoiIndex::new(&lines, &[1160.0 * keV..1180.0 * keV, 1320.0 * keV..1340.0 * keV]);
+/// let mut rates = [0.0; 2];
+/// roi.rates_for([(database.nuclide(nuclide!(Co - 60)), 1.0 * Ci)], &mut rates);
+/// assert!(rates[0] > 0.0 && rates[1] > 0.0);
+/// ```
+#[derive(Debug, Clone)]
+pub struct RoiIndex<'i, 'l> {
+    lines: &'i LineIndex<'l>,
+    windows: usize,
+    row_offsets: Vec<usize>,
+    columns: Vec<u32>,
+    values: Vec<f64>,
+}
+
+impl<'i, 'l> RoiIndex<'i, 'l> {
+    /// Builds ROI index for `windows` over all the nuclides in `lines`
+    pub fn new(lines: &'i LineIndex<'l>, windows: &[Range<f64>]) -> Self {
+        let nuclides = lines.nuclides().len();
+        let mut row_offsets = Vec::with_capacity(nuclides + 1);
+        let mut columns = Vec::new();
+        let mut values = Vec::new();
+        for position in 0..nuclides {
+            row_offsets.push(columns.len());
+            let nuclide_lines = lines.lines_at(position);
+            for (window, range) in windows.iter().enumerate() {
+                let first = nuclide_lines.energies.partition_point(|&e| e < range.start);
+                let last = nuclide_lines.energies.partition_point(|&e| e < range.end);
+                if first >= last {
+                    continue;
+                }
+                columns.push(window as u32);
+                values.push(nuclide_lines.intensities[first..last].iter().sum());
+            }
+        }
+        row_offsets.push(columns.len());
+        Self {
+            lines,
+            windows: windows.len(),
+            row_offsets,
+            columns,
+            values,
+        }
+    }
+
+    /// Number of windows
+    #[inline]
+    pub fn windows(&self) -> usize {
+        self.windows
+    }
+
+    /// Nuclides of the underlying [`LineIndex`]
+    #[inline]
+    pub fn nuclides(&self) -> &[&'l Nuclide<'l>] {
+        self.lines.nuclides()
+    }
+
+    /// Sparse row of the nuclide at `position`: window indices and intensities per decay
+    ///
+    /// ### Panics
+    /// If `position` is out of bounds of [`RoiIndex::nuclides`]
+    #[inline]
+    pub fn row(&self, position: usize) -> (&[u32], &[f64]) {
+        let range = self.row_offsets[position]..self.row_offsets[position + 1];
+        (&self.columns[range.clone()], &self.values[range])
+    }
+
+    #[inline]
+    fn add_row(&self, position: usize, decays: f64, out: &mut [f64]) {
+        let (columns, values) = self.row(position);
+        for (&window, &value) in columns.iter().zip(values) {
+            out[window as usize] += decays * value;
+        }
+    }
+
+    fn accumulate<'n>(
+        &self,
+        decays: impl IntoIterator<Item = (&'n Nuclide<'n>, f64)>,
+        out: &mut [f64],
+    ) {
+        assert_eq!(out.len(), self.windows, "output should match windows");
+        out.fill(0.0);
+        for (nuclide, decays) in decays {
+            if decays == 0.0 {
+                continue;
+            }
+            if let Some(position) = self.lines.position(nuclide) {
+                self.add_row(position, decays, out);
+            }
+        }
+    }
+
+    /// Writes summed rates in each window into `out`, given nuclide `activities`
+    ///
+    /// Nuclides absent from the index are ignored. Same function can be used with numbers of decays instead of activities, yielding counts
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`RoiIndex::windows`]
+    pub fn rates_for<'n>(
+        &self,
+        activities: impl IntoIterator<Item = (&'n Nuclide<'n>, f64)>,
+        out: &mut [f64],
+    ) {
+        self.accumulate(activities, out);
+    }
+
+    /// Writes summed rates in each window into `out`, given activities ordered as in [`RoiIndex::nuclides`]
+    ///
+    /// This form needs no nuclide lookup at all
+    ///
+    /// ### Panics
+    /// If `activities` length does not match nuclides, or `out` length is not equal to [`RoiIndex::windows`]
+    pub fn rates_for_row(&self, activities: &[f64], out: &mut [f64]) {
+        assert_eq!(
+            activities.len(),
+            self.nuclides().len(),
+            "activities should match nuclides"
+        );
+        assert_eq!(out.len(), self.windows, "output should match windows");
+        out.fill(0.0);
+        for (position, &activity) in activities.iter().enumerate() {
+            if activity != 0.0 {
+                self.add_row(position, activity, out);
+            }
+        }
+    }
+
+    /// Writes summed emission rates of `mixture` at `time` in each window into `out`
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`RoiIndex::windows`]
+    pub fn rates(&self, mixture: &NuclideMixture<'_>, time: f64, out: &mut [f64]) {
+        let mut tmp = core::mem::MaybeUninit::uninit();
+        let activities = mixture.activities_local(&mut tmp, time);
+        self.accumulate(
+            activities
+                .as_slice()
+                .iter()
+                .map(|&NuclideActivityPair { nuclide, activity }| (nuclide, activity)),
+            out,
+        );
+    }
+
+    /// Writes number of particles emitted by `mixture` in each window over time interval $[t; t + l]$ into `out`
+    ///
+    /// Numbers of decays of each nuclide are integrated analytically (see [`NuclideTimeEvolution::num_decays`](crate::wrapper::NuclideTimeEvolution::num_decays)), so unlike [`NuclideMixture::decay_photons_in_interval`], there's no time slicing involved
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`RoiIndex::windows`]
+    #[cfg(feature = "std")]
+    pub fn counts(
+        &self,
+        mixture: &NuclideMixture<'_>,
+        initial_age: f64,
+        duration: f64,
+        out: &mut [f64],
+    ) {
+        self.accumulate(
+            mixture
+                .decayed_to_nuclides_evolutions()
+                .iter()
+                .map(|evolution| {
+                    (
+                        evolution.nuclide,
+                        evolution.num_decays(initial_age, initial_age + duration),
+                    )
+                }),
+            out,
+        );
+    }
+}
@@ -0,0 +1,118 @@
+//! Scanning of database XML on Rust side
+//!
+//! `SandiaDecay` initialization materializes everything in the database. Sometimes only a small part of it is needed, e.g. a list of nuclides with their half-lives; [`nuclide_headers`] extracts just that from the database XML, with no C++ involved.
+//!
+//! Scanning does not produce a database: `SandiaDecay` can only be initialized from XML, so there is no way to hand values scanned here to it. Use it in place of initialization only when headers are all that's needed.
+//!
+//! Numbers are parsed with `core`'s correctly rounded float parser. For decimal values (which is what database files contain) results are bit-identical to ones stored by `SandiaDecay` (including single-precision fields, see [`NuclideHeader::atomic_mass`]). Values `strtod` would read partially (trailing garbage) or in another notation (hexadecimal floats) are reported as [`ScanError::BadNumber`] instead.
+//!
+//! Unsafe: no
+
+use crate::xml;
+
+/// Error while scanning database XML
+#[derive(Debug, Error, Clone, Copy, PartialEq, Eq)]
+pub enum ScanError {
+    /// Markup is not terminated
+    #[error("Unterminated markup at byte {0}")]
+    Syntax(usize),
+    /// Required attribute is missing
+    #[error("Element at byte {offset} misses attribute {attribute:?}")]
+    MissingAttribute {
+        /// Byte offset of the element
+        offset: usize,
+        /// Attribute name
+        attribute: &'static str,
+    },
+    /// Attribute value is not a valid number
+    #[error("Element at byte {offset} has invalid value of attribute {attribute:?}")]
+    BadNumber {
+        /// Byte offset of the element
+        offset: usize,
+        /// Attribute name
+        attribute: &'static str,
+    },
+}
+
+/// Nuclide data, stored in the attributes of `<nuclide>` element
+///
+/// Fields have the same meaning and units as ones of [`Nuclide`](crate::wrapper::Nuclide)
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct NuclideHeader<'s> {
+    /// Nuclide symbol, e.g. `Co60`
+    pub symbol: &'s str,
+    /// Number of protons in the nucleus
+    pub atomic_number: i16,
+    /// Number of nucleons in the nucleus
+    pub mass_number: i16,
+    /// Nuclear excitation state (isomer number)
+    pub isomer_number: i16,
+    /// Atomic mass in a.m.u.
+    ///
+    /// Parsed as `f64` and narrowed, same as `SandiaDecay` does
+    pub atomic_mass: f32,
+    /// Half-life, in units of [`crate::cst`]
+    pub half_life: f64,
+    /// Byte offset of the element in the XML
+    pub offset: usize,
+}
+
+impl<'s> NuclideHeader<'s> {
+    pub(crate) fn from_tag(tag: &xml::Tag<'s>) -> Result<Self, ScanError> {
+        Ok(Self {
+            symbol: attribute(tag, "symbol")?,
+            atomic_number: number(tag, "atomicNumber", xml::parse_i16)?,
+            mass_number: number(tag, "massNumber", xml::parse_i16)?,
+            isomer_number: number(tag, "isomerNumber", xml::parse_i16)?,
+            atomic_mass: number(tag, "atomicMass", xml::parse_f32)?,
+            half_life: number(tag, "halfLife", xml::parse_f64)? * crate::cst::second,
+            offset: tag.offset,
+        })
+    }
+}
+
+/// Iterates over headers of all the nuclides in database `xml`
+///
+/// Malformed nuclide elements are reported, and scanning continues. Unterminated markup ends iteration
+///
+/// ### Example
+/// ```rust,no_run
+/// # use sdecay::scan::nuclide_headers;
+/// let xml = std::fs::read_to_string("sandia.decay.xml").unwrap();
+/// let long_lived = nuclide_headers(&xml)
+///     .filter_map(Result::ok)
+///     .filter(|header| header.half_life > 1e9 * sdecay::cst::year)
+///     .count();
+/// ```
+pub fn nuclide_headers(
+    xml: &str,
+) -> impl Iterator<Item = Result<NuclideHeader<'_>, ScanError>> + '_ {
+    xml::tags(xml).filter_map(|tag| match tag {
+        Ok(tag) if tag.name == "nuclide" => Some(NuclideHeader::from_tag(&tag)),
+        Ok(_) => None,
+        Err(offset) => Some(Err(ScanError::Syntax(offset))),
+    })
+}
+
+/// Value of required attribute
+pub(crate) fn attribute<'s>(
+    tag: &xml::Tag<'s>,
+    attribute: &'static str,
+) -> Result<&'s str, ScanError> {
+    tag.attribute(attribute).ok_or(ScanError::MissingAttribute {
+        offset: tag.offset,
+        attribute,
+    })
+}
+
+/// Value of required numeric attribute
+pub(crate) fn number<T>(
+    tag: &xml::Tag<'_>,
+    name: &'static str,
+    parse: fn(&str) -> Option<T>,
+) -> Result<T, ScanError> {
+    parse(attribute(tag, name)?).ok_or(ScanError::BadNumber {
+        offset: tag.offset,
+        attribute: name,
+    })
+}
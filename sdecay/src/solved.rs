@@ -0,0 +1,594 @@
+//! Immutable, thread-safe solved form of a nuclide mixture
+//!
+//! `SandiaDecay`'s [`NuclideMixture`] solves it's evolution lazily, from `const` methods, so even "read-only" queries may mutate it. [`SolvedMixture`] is obtained with an explicit [`NuclideMixture::solve`] call: it copies evolution coefficients into flat Rust-owned tables, and is never mutated afterwards. It is [`Send`] and [`Sync`], so a single solved inventory can be queried from any number of threads at once (e.g. behind an [`Arc`](std::sync::Arc)), with no locking.
+//!
+//! Large inventories can be evaluated on multiple threads (see [`SolvedMixture::line_rates_parallel`] and similar); results are reduced in a fixed order, so they do not depend on number of threads.
+//!
+//! Solved mixtures can be stored with [`SolvedMixture::to_bytes`] and loaded back with [`SolvedMixture::from_bytes`], without re-solving.
+//!
+//! Unsafe: no
+
+use alloc::vec::Vec;
+
+use crate::{
+    lines::{LineIndex, nuclide_key},
+    ordinal::NuclideOrdinals,
+    parallel,
+    wrapper::{Nuclide, NuclideMixture, term_integral},
+};
+
+/// Magic bytes of serialized [`SolvedMixture`]
+const MAGIC: [u8; 4] = *b"SDSM";
+/// Current version of serialization format
+const VERSION: u16 = 1;
+
+/// Error returned by [`SolvedMixture::from_bytes`]
+#[derive(Debug, Error, PartialEq, Eq)]
+pub enum DecodeError {
+    /// Data does not start with expected magic bytes
+    #[error("Not a serialized solved mixture")]
+    BadMagic,
+    /// Data was serialized with unsupported format version
+    #[error("Unsupported format version {0}")]
+    UnsupportedVersion(u16),
+    /// Data was serialized against a different database
+    #[error("Database fingerprint mismatch: expected {expected:#018x}, found {found:#018x}")]
+    FingerprintMismatch {
+        /// Fingerprint of the database used for decoding
+        expected: u64,
+        /// Fingerprint stored in the data
+        found: u64,
+    },
+    /// Nuclide ordinal is out of range of the database
+    #[error("Unknown nuclide ordinal {0}")]
+    UnknownOrdinal(u32),
+    /// Data ended prematurely, or contains inconsistent counts
+    #[error("Truncated or malformed data")]
+    Malformed,
+}
+
+/// Little-endian reader over serialized data
+struct Reader<'b>(&'b [u8]);
+
+impl Reader<'_> {
+    fn take<const N: usize>(&mut self) -> Result<[u8; N], DecodeError> {
+        let (head, tail) = self
+            .0
+            .split_first_chunk::<N>()
+            .ok_or(DecodeError::Malformed)?;
+        self.0 = tail;
+        Ok(*head)
+    }
+
+    fn u16(&mut self) -> Result<u16, DecodeError> {
+        self.take().map(u16::from_le_bytes)
+    }
+
+    fn u32(&mut self) -> Result<u32, DecodeError> {
+        self.take().map(u32::from_le_bytes)
+    }
+
+    fn u64(&mut self) -> Result<u64, DecodeError> {
+        self.take().map(u64::from_le_bytes)
+    }
+
+    fn f64(&mut self) -> Result<f64, DecodeError> {
+        self.take().map(f64::from_le_bytes)
+    }
+
+    /// Reads a count, checking that at least `count * item_size` bytes remain
+    fn count(&mut self, item_size: usize) -> Result<usize, DecodeError> {
+        let count = self.u32()? as usize;
+        if count.saturating_mul(item_size) > self.0.len() {
+            return Err(DecodeError::Malformed);
+        }
+        Ok(count)
+    }
+}
+
+/// Number of points, at which nuclide evolution is sampled to estimate it's peak within time window
+const PRUNE_SAMPLES: usize = 64;
+
+/// Outcome of [`SolvedMixture::pruned`]
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct PruneReport {
+    /// Number of evolution terms before pruning
+    pub terms_before: usize,
+    /// Number of evolution terms after pruning
+    pub terms_after: usize,
+    /// Realized bound on error of any nuclide's number of atoms within time window, relative to (estimated) peak number of atoms of this nuclide within the window
+    pub max_relative_error: f64,
+    /// Realized bound on absolute error of total activity within time window
+    pub total_activity_error: f64,
+}
+
+/// Solved nuclide mixture, see [module-level docs](self)
+///
+/// Nuclides are stored in the same order as in [`NuclideMixture::decayed_to_nuclides_evolutions`] of the original mixture. Evolution of nuclide $n$ is
+/// $$
+/// N_n(t) = \sum_i c_{n,i} e^{-k_{n,i} t}
+/// $$
+/// with time measured from mixture's $t = 0$
+#[derive(Debug, Clone)]
+pub struct SolvedMixture<'l> {
+    nuclides: Vec<&'l Nuclide<'l>>,
+    decay_constants: Vec<f64>,
+    term_offsets: Vec<usize>,
+    coefficients: Vec<f64>,
+    exponents: Vec<f64>,
+    /// `(solution index, number of atoms)` of initial nuclides
+    initial: Vec<(u32, f64)>,
+    /// `(nuclide key, solution index)`, sorted by key
+    lookup: Vec<(usize, u32)>,
+}
+
+impl<'l> SolvedMixture<'l> {
+    /// Solves `mixture` (if it was not solved yet) and copies the solution
+    pub fn new(mixture: &NuclideMixture<'l>) -> Self {
+        let evolutions = mixture.decayed_to_nuclides_evolutions();
+        let mut nuclides = Vec::with_capacity(evolutions.len());
+        let mut decay_constants = Vec::with_capacity(evolutions.len());
+        let mut term_offsets = Vec::with_capacity(evolutions.len() + 1);
+        let mut coefficients = Vec::new();
+        let mut exponents = Vec::new();
+        for evolution in evolutions {
+            nuclides.push(evolution.nuclide);
+            decay_constants.push(evolution.nuclide.decay_constant());
+            term_offsets.push(coefficients.len());
+            for term in evolution.evolution_terms.as_slice() {
+                coefficients.push(term.term_coeff);
+                exponents.push(term.exponential_coeff);
+            }
+        }
+        term_offsets.push(coefficients.len());
+        let mut solved = Self::from_parts(
+            nuclides,
+            decay_constants,
+            term_offsets,
+            coefficients,
+            exponents,
+            Vec::new(),
+        );
+        solved.initial = mixture
+            .initial_nuclide_num_atoms()
+            .filter_map(|pair| Some((solved.index(pair.nuclide)? as u32, pair.num_atoms)))
+            .collect();
+        solved
+    }
+
+    /// Assembles solved mixture from it's tables, building nuclide lookup
+    pub(crate) fn from_parts(
+        nuclides: Vec<&'l Nuclide<'l>>,
+        decay_constants: Vec<f64>,
+        term_offsets: Vec<usize>,
+        coefficients: Vec<f64>,
+        exponents: Vec<f64>,
+        initial: Vec<(u32, f64)>,
+    ) -> Self {
+        let mut lookup = nuclides
+            .iter()
+            .enumerate()
+            .map(|(index, nuclide)| (nuclide_key(nuclide), index as u32))
+            .collect::<Vec<_>>();
+        lookup.sort_unstable();
+        Self {
+            nuclides,
+            decay_constants,
+            term_offsets,
+            coefficients,
+            exponents,
+            initial,
+            lookup,
+        }
+    }
+
+    /// Size of [`SolvedMixture::to_bytes`] output, in bytes
+    pub fn serialized_len(&self) -> usize {
+        4 + 2 + 8 + 4 * 3 + self.len() * (4 + 4) + self.num_terms() * 16 + self.initial.len() * 12
+    }
+
+    /// Serializes solved mixture into a compact binary form, appending it to `out`
+    ///
+    /// Nuclides are referenced by their `ordinals`, and database fingerprint is stored along; decay constants are not stored, since they are defined by the database. All numbers are little-endian
+    ///
+    /// ### Panics
+    /// If mixture contains nuclides from a different database
+    pub fn write_bytes(&self, ordinals: &NuclideOrdinals<'_>, out: &mut Vec<u8>) {
+        out.reserve(self.serialized_len());
+        out.extend_from_slice(&MAGIC);
+        out.extend_from_slice(&VERSION.to_le_bytes());
+        out.extend_from_slice(&ordinals.fingerprint().to_le_bytes());
+        for count in [self.len(), self.num_terms(), self.initial.len()] {
+            out.extend_from_slice(&(count as u32).to_le_bytes());
+        }
+        for (index, nuclide) in self.nuclides.iter().enumerate() {
+            let ordinal = ordinals
+                .ordinal(nuclide)
+                .expect("nuclide should belong to the database");
+            let terms = self.term_offsets[index + 1] - self.term_offsets[index];
+            out.extend_from_slice(&(ordinal as u32).to_le_bytes());
+            out.extend_from_slice(&(terms as u32).to_le_bytes());
+        }
+        for value in self.coefficients.iter().chain(&self.exponents) {
+            out.extend_from_slice(&value.to_le_bytes());
+        }
+        for &(index, atoms) in &self.initial {
+            out.extend_from_slice(&index.to_le_bytes());
+            out.extend_from_slice(&atoms.to_le_bytes());
+        }
+    }
+
+    /// Same as [`SolvedMixture::write_bytes`], but allocates the output
+    pub fn to_bytes(&self, ordinals: &NuclideOrdinals<'_>) -> Vec<u8> {
+        let mut out = Vec::new();
+        self.write_bytes(ordinals, &mut out);
+        out
+    }
+
+    /// Deserializes solved mixture, written by [`SolvedMixture::write_bytes`]
+    ///
+    /// No solving is involved: coefficient tables are read as-is
+    ///
+    /// ### Errors
+    /// See [`DecodeError`] variants
+    pub fn from_bytes(bytes: &[u8], ordinals: &NuclideOrdinals<'l>) -> Result<Self, DecodeError> {
+        let mut reader = Reader(bytes);
+        if reader.take::<4>()? != MAGIC {
+            return Err(DecodeError::BadMagic);
+        }
+        let version = reader.u16()?;
+        if version != VERSION {
+            return Err(DecodeError::UnsupportedVersion(version));
+        }
+        let found = reader.u64()?;
+        if found != ordinals.fingerprint() {
+            return Err(DecodeError::FingerprintMismatch {
+                expected: ordinals.fingerprint(),
+                found,
+            });
+        }
+        let num_nuclides = reader.count(8)?;
+        let num_terms = reader.count(16)?;
+        let num_initial = reader.count(12)?;
+        let mut nuclides = Vec::with_capacity(num_nuclides);
+        let mut decay_constants = Vec::with_capacity(num_nuclides);
+        let mut term_offsets = Vec::with_capacity(num_nuclides + 1);
+        term_offsets.push(0);
+        for _ in 0..num_nuclides {
+            let ordinal = reader.u32()?;
+            let nuclide = ordinals
+                .nuclide(ordinal as usize)
+                .ok_or(DecodeError::UnknownOrdinal(ordinal))?;
+            nuclides.push(nuclide);
+            decay_constants.push(nuclide.decay_constant());
+            let terms = reader.u32()? as usize;
+            term_offsets.push(term_offsets[term_offsets.len() - 1] + terms);
+        }
+        if term_offsets[num_nuclides] != num_terms {
+            return Err(DecodeError::Malformed);
+        }
+        let coefficients = (0..num_terms)
+            .map(|_| reader.f64())
+            .collect::<Result<Vec<_>, _>>()?;
+        let exponents = (0..num_terms)
+            .map(|_| reader.f64())
+            .collect::<Result<Vec<_>, _>>()?;
+        let initial = (0..num_initial)
+            .map(|_| {
+                let index = reader.u32()?;
+                if index as usize >= num_nuclides {
+                    return Err(DecodeError::Malformed);
+                }
+                Ok((index, reader.f64()?))
+            })
+            .collect::<Result<Vec<_>, _>>()?;
+        if !reader.0.is_empty() {
+            return Err(DecodeError::Malformed);
+        }
+        Ok(Self::from_parts(
+            nuclides,
+            decay_constants,
+            term_offsets,
+            coefficients,
+            exponents,
+            initial,
+        ))
+    }
+
+    /// Number of solution nuclides
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.nuclides.len()
+    }
+
+    /// Checks if there are no solution nuclides
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.nuclides.is_empty()
+    }
+
+    /// Solution nuclides
+    #[inline]
+    pub fn nuclides(&self) -> &[&'l Nuclide<'l>] {
+        &self.nuclides
+    }
+
+    /// Decay constants of solution nuclides
+    #[inline]
+    pub fn decay_constants(&self) -> &[f64] {
+        &self.decay_constants
+    }
+
+    /// Total number of evolution terms
+    #[inline]
+    pub fn num_terms(&self) -> usize {
+        self.coefficients.len()
+    }
+
+    /// Evolution terms of the nuclide at `index`: coefficients $c_{n,i}$ and exponents $k_{n,i}$
+    ///
+    /// ### Panics
+    /// If `index` is out of bounds
+    #[inline]
+    pub fn terms(&self, index: usize) -> (&[f64], &[f64]) {
+        let range = self.term_offsets[index]..self.term_offsets[index + 1];
+        (&self.coefficients[range.clone()], &self.exponents[range])
+    }
+
+    /// Initial nuclides of the mixture and their numbers of atoms
+    pub fn initial_nuclides(&self) -> impl ExactSizeIterator<Item = (&'l Nuclide<'l>, f64)> + '_ {
+        self.initial
+            .iter()
+            .map(|&(index, atoms)| (self.nuclides[index as usize], atoms))
+    }
+
+    /// Solution index of the `nuclide`
+    #[inline]
+    pub fn index(&self, nuclide: &Nuclide<'_>) -> Option<usize> {
+        let key = nuclide_key(nuclide);
+        self.lookup
+            .binary_search_by_key(&key, |&(key, _)| key)
+            .ok()
+            .map(|position| self.lookup[position].1 as usize)
+    }
+
+    /// Number of atoms at `time` of the nuclide at `index`
+    ///
+    /// ### Panics
+    /// If `index` is out of bounds
+    #[inline]
+    pub fn num_atoms_at(&self, time: f64, index: usize) -> f64 {
+        let (coefficients, exponents) = self.terms(index);
+        coefficients
+            .iter()
+            .zip(exponents)
+            .map(|(c, k)| c * (-k * time).exp())
+            .sum()
+    }
+
+    /// Activity at `time` of the nuclide at `index`
+    ///
+    /// ### Panics
+    /// If `index` is out of bounds
+    #[inline]
+    pub fn activity_at(&self, time: f64, index: usize) -> f64 {
+        self.num_atoms_at(time, index) * self.decay_constants[index]
+    }
+
+    /// Number of decays in $[t_0; t_1]$ of the nuclide at `index`
+    ///
+    /// ### Panics
+    /// If `index` is out of bounds
+    pub fn num_decays_at(&self, t0: f64, t1: f64, index: usize) -> f64 {
+        let (coefficients, exponents) = self.terms(index);
+        let atom_seconds: f64 = coefficients
+            .iter()
+            .zip(exponents)
+            .map(|(&c, &k)| term_integral(c, k, t0, t1))
+            .sum();
+        atom_seconds * self.decay_constants[index]
+    }
+
+    /// Number of atoms of the `nuclide` at `time`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide is not among the solution nuclides
+    #[inline]
+    pub fn num_atoms(&self, time: f64, nuclide: &Nuclide<'_>) -> Option<f64> {
+        self.index(nuclide)
+            .map(|index| self.num_atoms_at(time, index))
+    }
+
+    /// Activity of the `nuclide` at `time`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide is not among the solution nuclides
+    #[inline]
+    pub fn activity(&self, time: f64, nuclide: &Nuclide<'_>) -> Option<f64> {
+        self.index(nuclide)
+            .map(|index| self.activity_at(time, index))
+    }
+
+    /// Writes activities of all the solution nuclides at `time` into `out`
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`SolvedMixture::len`]
+    pub fn activities_into(&self, time: f64, out: &mut [f64]) {
+        assert_eq!(out.len(), self.len(), "output should match nuclides");
+        for (index, out) in out.iter_mut().enumerate() {
+            *out = self.activity_at(time, index);
+        }
+    }
+
+    /// Total activity at `time`
+    pub fn total_activity(&self, time: f64) -> f64 {
+        (0..self.len())
+            .map(|index| self.activity_at(time, index))
+            .sum()
+    }
+
+    /// Writes number of decays of all the solution nuclides in $[t_0; t_1]$ into `out`
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`SolvedMixture::len`]
+    pub fn num_decays_into(&self, t0: f64, t1: f64, out: &mut [f64]) {
+        assert_eq!(out.len(), self.len(), "output should match nuclides");
+        for (index, out) in out.iter_mut().enumerate() {
+            *out = self.num_decays_at(t0, t1, index);
+        }
+    }
+
+    /// Drops evolution terms, negligible within time window $[t_0; t_1]$
+    ///
+    /// Term $c e^{-k t}$ contributes at most $|c| \max(e^{-k t_0}, e^{-k t_1})$ anywhere within the window. For each nuclide, terms are dropped starting with the smallest such bound, while sum of bounds of dropped terms stays within `tolerance` times peak number of atoms of this nuclide in the window (estimated by sampling, never exceeding true peak). This removes terms of short-lived intermediates (if $t_0$ is well above their half-lives) and terms with tiny coefficients.
+    ///
+    /// Evaluations outside of the window are not bounded in any way.
+    ///
+    /// ### Returns
+    /// Pruned mixture, and a report with the realized error bounds
+    ///
+    /// ### Panics
+    /// If window is not valid (`t0 > t1`) or `tolerance` is negative
+    pub fn pruned(&self, t0: f64, t1: f64, tolerance: f64) -> (Self, PruneReport) {
+        assert!(t0 <= t1, "time window should be valid");
+        assert!(tolerance >= 0.0, "tolerance should be non-negative");
+        let mut term_offsets = Vec::with_capacity(self.term_offsets.len());
+        let mut coefficients = Vec::new();
+        let mut exponents = Vec::new();
+        let mut bounds = Vec::new();
+        let mut max_relative_error = 0.0_f64;
+        let mut total_activity_error = 0.0;
+        for index in 0..self.len() {
+            let (coeffs, exps) = self.terms(index);
+            let peak = (0..=PRUNE_SAMPLES)
+                .map(|sample| {
+                    let time = t0 + (t1 - t0) * sample as f64 / PRUNE_SAMPLES as f64;
+                    self.num_atoms_at(time, index).abs()
+                })
+                .fold(0.0, f64::max);
+            bounds.clear();
+            bounds.extend(
+                coeffs
+                    .iter()
+                    .zip(exps)
+                    .enumerate()
+                    .map(|(term, (c, k))| (c.abs() * (-k * t0).exp().max((-k * t1).exp()), term)),
+            );
+            bounds.sort_by(|(a, _), (b, _)| a.total_cmp(b));
+            let budget = tolerance * peak;
+            let mut dropped = 0.0;
+            let mut keep = bounds.len();
+            for (position, &(bound, _)) in bounds.iter().enumerate() {
+                if dropped + bound > budget {
+                    break;
+                }
+                dropped += bound;
+                keep = bounds.len() - position - 1;
+            }
+            let mut kept = bounds[bounds.len() - keep..]
+                .iter()
+                .map(|&(_, term)| term)
+                .collect::<Vec<_>>();
+            kept.sort_unstable();
+            term_offsets.push(coefficients.len());
+            coefficients.extend(kept.iter().map(|&term| coeffs[term]));
+            exponents.extend(kept.iter().map(|&term| exps[term]));
+            if dropped > 0.0 {
+                max_relative_error = max_relative_error.max(dropped / peak);
+                total_activity_error += dropped * self.decay_constants[index];
+            }
+        }
+        term_offsets.push(coefficients.len());
+        let report = PruneReport {
+            terms_before: self.num_terms(),
+            terms_after: coefficients.len(),
+            max_relative_error,
+            total_activity_error,
+        };
+        let pruned = Self {
+            nuclides: self.nuclides.clone(),
+            decay_constants: self.decay_constants.clone(),
+            term_offsets,
+            coefficients,
+            exponents,
+            initial: self.initial.clone(),
+            lookup: self.lookup.clone(),
+        };
+        (pruned, report)
+    }
+
+    /// Writes number of decays of all the solution nuclides in $[t_0; t_1]$ into `out`, splitting nuclides between `threads`
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`SolvedMixture::len`]
+    pub fn num_decays_parallel(&self, t0: f64, t1: f64, out: &mut [f64], threads: usize) {
+        assert_eq!(out.len(), self.len(), "output should match nuclides");
+        parallel::for_each_mut(out, 1, threads, |nuclides, out| {
+            for (index, out) in nuclides.zip(out) {
+                *out = self.num_decays_at(t0, t1, index);
+            }
+        });
+    }
+
+    /// Emission rates of `lines` at `time`, splitting nuclides between `threads`
+    ///
+    /// ### Returns
+    /// `(energy, rate)` pairs sorted by energy, with rates of equal energies combined. Rates are summed in nuclide order, so result does not depend on number of threads
+    pub fn line_rates_parallel(
+        &self,
+        lines: &LineIndex<'_>,
+        time: f64,
+        threads: usize,
+    ) -> Vec<(f64, f64)> {
+        self.lines_parallel(lines, threads, |index| self.activity_at(time, index))
+    }
+
+    /// Number of particles of `lines` emitted in $[t_0; t_1]$, see [`SolvedMixture::line_rates_parallel`]
+    pub fn line_counts_parallel(
+        &self,
+        lines: &LineIndex<'_>,
+        t0: f64,
+        t1: f64,
+        threads: usize,
+    ) -> Vec<(f64, f64)> {
+        self.lines_parallel(lines, threads, |index| self.num_decays_at(t0, t1, index))
+    }
+
+    /// Accumulates lines of each nuclide, weighted by `per_nuclide` value
+    fn lines_parallel(
+        &self,
+        lines: &LineIndex<'_>,
+        threads: usize,
+        per_nuclide: impl Fn(usize) -> f64 + Sync,
+    ) -> Vec<(f64, f64)> {
+        let chunks = parallel::map(self.len(), threads, |_, nuclides| {
+            let mut out = Vec::new();
+            for index in nuclides {
+                let Some(position) = lines.position(self.nuclides[index]) else {
+                    continue;
+                };
+                let value = per_nuclide(index);
+                let nuclide_lines = lines.lines_at(position);
+                out.extend(
+                    nuclide_lines
+                        .energies
+                        .iter()
+                        .zip(nuclide_lines.intensities)
+                        .map(|(&energy, &intensity)| (energy, intensity * value)),
+                );
+            }
+            out
+        });
+        let mut out = chunks.concat();
+        // stable sort keeps equal energies in nuclide order
+        out.sort_by(|(a, _), (b, _)| a.total_cmp(b));
+        out.dedup_by(|(energy, value), (kept_energy, kept_value)| {
+            let equal = energy == kept_energy;
+            if equal {
+                *kept_value += *value;
+            }
+            equal
+        });
+        out
+    }
+}
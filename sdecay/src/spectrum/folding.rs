@@ -0,0 +1,363 @@
+use alloc::vec::Vec;
+
+use crate::{
+    spectrum::Binning,
+    wrapper::{EnergyCountPair, EnergyRatePair, HowToOrder, NuclideMixture},
+};
+
+/// Number of output channels in a single cache block of a dense response
+const CHANNEL_BLOCK: usize = 512;
+
+#[derive(Debug, Clone)]
+enum Storage {
+    /// Column-major storage, split into blocks of [`CHANNEL_BLOCK`] channels
+    ///
+    /// Block $k$ stores, for each input bin, channels $[k \cdot B; (k + 1) \cdot B)$ contiguously. This way, folding a whole spectrum keeps a single block of output in cache. Last block is narrower, if number of channels is not a multiple of $B$
+    Dense { values: Vec<f64> },
+    /// For each input bin, only a contiguous range of non-zero channels is stored
+    Banded {
+        offsets: Vec<usize>,
+        starts: Vec<u32>,
+        values: Vec<f64>,
+    },
+}
+
+/// User-provided detector response, mapping emitted photons to measured spectrum channels
+///
+/// Response is defined on an input [`Binning`] (photon energies); column $b$ is the measured spectrum produced by a unit photon flux in input bin $b$ (full-energy peak, Compton continuum, escape peaks, etc)
+///
+/// Response can be stored either dense, or banded (with only the non-zero range of each column stored). All the folding loops run over contiguous memory, and are written to be auto-vectorized
+#[derive(Debug, Clone)]
+pub struct DetectorResponse {
+    binning: Binning,
+    channels: usize,
+    storage: Storage,
+}
+
+impl DetectorResponse {
+    /// Creates dense response
+    ///
+    /// `column` is called once for every input bin, and should fill response column (of length `channels`) for it. Column is zeroed before the call
+    pub fn dense(
+        binning: Binning,
+        channels: usize,
+        mut column: impl FnMut(usize, &mut [f64]),
+    ) -> Self {
+        let bins = binning.len();
+        let mut values = alloc::vec![0.0; bins * channels];
+        let mut scratch = alloc::vec![0.0; channels];
+        for bin in 0..bins {
+            scratch.fill(0.0);
+            column(bin, &mut scratch);
+            for (block, chunk) in scratch.chunks(CHANNEL_BLOCK).enumerate() {
+                let start = Self::dense_offset(bins, channels, block, bin);
+                values[start..start + chunk.len()].copy_from_slice(chunk);
+            }
+        }
+        Self {
+            binning,
+            channels,
+            storage: Storage::Dense { values },
+        }
+    }
+
+    /// Creates banded response
+    ///
+    /// `column` is called once for every input bin, and should fill response column (of length `channels`) for it. Column is zeroed before the call. Leading and trailing zeros of each column are not stored
+    pub fn banded(
+        binning: Binning,
+        channels: usize,
+        mut column: impl FnMut(usize, &mut [f64]),
+    ) -> Self {
+        let bins = binning.len();
+        let mut offsets = Vec::with_capacity(bins + 1);
+        let mut starts = Vec::with_capacity(bins);
+        let mut values = Vec::new();
+        let mut scratch = alloc::vec![0.0; channels];
+        for bin in 0..bins {
+            scratch.fill(0.0);
+            column(bin, &mut scratch);
+            let start = scratch.iter().position(|&v| v != 0.0).unwrap_or(0);
+            let end = scratch.iter().rposition(|&v| v != 0.0).map_or(0, |i| i + 1);
+            offsets.push(values.len());
+            starts.push(start as u32);
+            if start < end {
+                values.extend_from_slice(&scratch[start..end]);
+            }
+        }
+        offsets.push(values.len());
+        Self {
+            binning,
+            channels,
+            storage: Storage::Banded {
+                offsets,
+                starts,
+                values,
+            },
+        }
+    }
+
+    /// Offset of `bin`'s column in channel `block` of dense storage
+    ///
+    /// Column occupies as many values as there are channels in the block, i.e. [`CHANNEL_BLOCK`] for all but the last block
+    #[inline]
+    fn dense_offset(bins: usize, channels: usize, block: usize, bin: usize) -> usize {
+        let first = block * CHANNEL_BLOCK;
+        let width = CHANNEL_BLOCK.min(channels - first);
+        first * bins + bin * width
+    }
+
+    /// Input (photon energy) binning
+    #[inline]
+    pub fn binning(&self) -> &Binning {
+        &self.binning
+    }
+
+    /// Number of output channels
+    #[inline]
+    pub fn channels(&self) -> usize {
+        self.channels
+    }
+
+    /// Adds `weight` times response column of input `bin` to `out`
+    #[inline]
+    fn add_column(&self, bin: usize, weight: f64, out: &mut [f64]) {
+        match &self.storage {
+            Storage::Dense { values } => {
+                let bins = self.binning.len();
+                for (block, out) in out.chunks_mut(CHANNEL_BLOCK).enumerate() {
+                    let start = Self::dense_offset(bins, self.channels, block, bin);
+                    axpy(weight, &values[start..start + out.len()], out);
+                }
+            }
+            Storage::Banded {
+                offsets,
+                starts,
+                values,
+            } => {
+                let column = &values[offsets[bin]..offsets[bin + 1]];
+                let start = starts[bin] as usize;
+                axpy(weight, column, &mut out[start..start + column.len()]);
+            }
+        }
+    }
+
+    /// Folds lines (pairs of energy and rate, or count) into `out` spectrum
+    ///
+    /// Result is added to `out`; lines outside of the input binning are ignored
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`DetectorResponse::channels`]
+    pub fn fold_lines(&self, lines: impl IntoIterator<Item = (f64, f64)>, out: &mut [f64]) {
+        assert_eq!(out.len(), self.channels, "output should match channels");
+        for (energy, rate) in lines {
+            if rate == 0.0 {
+                continue;
+            }
+            if let Some(bin) = self.binning.find(energy) {
+                self.add_column(bin, rate, out);
+            }
+        }
+    }
+
+    /// Folds line rates, as returned by [`NuclideMixture::photons`](crate::wrapper::NuclideMixture::photons) and similar functions, directly into `out`
+    ///
+    /// Same as [`DetectorResponse::fold_lines`]
+    pub fn fold_rates(&self, lines: &[EnergyRatePair], out: &mut [f64]) {
+        self.fold_lines(
+            lines.iter().map(
+                |&EnergyRatePair {
+                     energy,
+                     num_per_second,
+                 }| (energy, num_per_second),
+            ),
+            out,
+        );
+    }
+
+    /// Folds line counts, as returned by [`NuclideMixture::decay_photons_in_interval`](crate::wrapper::NuclideMixture::decay_photons_in_interval) and similar functions, directly into `out`
+    ///
+    /// Same as [`DetectorResponse::fold_lines`]
+    pub fn fold_counts(&self, lines: &[EnergyCountPair], out: &mut [f64]) {
+        self.fold_lines(
+            lines
+                .iter()
+                .map(|&EnergyCountPair { energy, count }| (energy, count)),
+            out,
+        );
+    }
+
+    /// Folds photons emitted by `mixture` at `time` into `out`
+    ///
+    /// Line rates returned by [`NuclideMixture::photons`] are consumed in-place, with no intermediate binned spectrum
+    pub fn fold_photons(&self, mixture: &NuclideMixture<'_>, time: f64, out: &mut [f64]) {
+        let mut tmp = core::mem::MaybeUninit::uninit();
+        let photons = mixture.photons_local(&mut tmp, time, HowToOrder::OrderByEnergy);
+        self.fold_rates(photons.as_slice(), out);
+    }
+
+    /// Folds a spectrum binned with input [`DetectorResponse::binning`] into `out`
+    ///
+    /// Result is added to `out`. Dense responses are applied one channel block at a time, so that output block stays in cache
+    ///
+    /// ### Panics
+    /// If `input` length does not match input binning, or `out` length is not equal to [`DetectorResponse::channels`]
+    pub fn fold_spectrum(&self, input: &[f64], out: &mut [f64]) {
+        assert_eq!(
+            input.len(),
+            self.binning.len(),
+            "input should match binning"
+        );
+        assert_eq!(out.len(), self.channels, "output should match channels");
+        match &self.storage {
+            Storage::Dense { values } => {
+                let bins = self.binning.len();
+                for (block, out) in out.chunks_mut(CHANNEL_BLOCK).enumerate() {
+                    for (bin, &weight) in input.iter().enumerate() {
+                        if weight == 0.0 {
+                            continue;
+                        }
+                        let start = Self::dense_offset(bins, self.channels, block, bin);
+                        axpy(weight, &values[start..start + out.len()], out);
+                    }
+                }
+            }
+            Storage::Banded { .. } => {
+                for (bin, &weight) in input.iter().enumerate() {
+                    if weight != 0.0 {
+                        self.add_column(bin, weight, out);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// `out += a * x`
+#[inline]
+fn axpy(a: f64, x: &[f64], out: &mut [f64]) {
+    for (out, x) in out.iter_mut().zip(x) {
+        *out += a * x;
+    }
+}
+
+/// Convolves `spectrum` with a Gaussian kernel of standard deviation `sigma` (in channels)
+///
+/// Kernel is truncated at $\pm 5 \sigma$ and normalized, so total counts are preserved (except for leakage through spectrum edges). Long spectra with wide kernels are convolved via FFT, others directly
+///
+/// ### Example
+/// ```rust
+/// # use sdecay::spectrum::gaussian_convolve;
+/// let mut spectrum = vec![0.0; 64];
+/// spectrum[32] = 1.0;
+/// let broadened = gaussian_convolve(&spectrum, 2.0);
+/// assert!((broadened.iter().sum::<f64>() - 1.0).abs() < 1e-9);
+/// assert!(broadened[32] > broadened[30]);
+/// ```
+#[cfg(feature = "std")]
+pub fn gaussian_convolve(spectrum: &[f64], sigma: f64) -> Vec<f64> {
+    if sigma.is_nan() || sigma <= 0.0 || spectrum.is_empty() {
+        return spectrum.to_vec();
+    }
+    let half = (5.0 * sigma).ceil() as usize;
+    let mut kernel = (0..=2 * half)
+        .map(|i| {
+            let x = (i as f64 - half as f64) / sigma;
+            (-0.5 * x * x).exp()
+        })
+        .collect::<Vec<_>>();
+    let norm: f64 = kernel.iter().sum();
+    kernel.iter_mut().for_each(|k| *k /= norm);
+    // direct convolution costs n * k, FFT about 3 * m * log2(m) with padding
+    let direct_cost = spectrum.len() * kernel.len();
+    let padded = (spectrum.len() + kernel.len() - 1).next_power_of_two();
+    let fft_cost = 3 * padded * padded.trailing_zeros() as usize * 4;
+    if direct_cost <= fft_cost {
+        let mut out = alloc::vec![0.0; spectrum.len()];
+        for (i, &value) in spectrum.iter().enumerate() {
+            if value == 0.0 {
+                continue;
+            }
+            let first = i.saturating_sub(half);
+            let last = (i + half).min(spectrum.len() - 1);
+            let kernel = &kernel[first + half - i..=last + half - i];
+            axpy(value, kernel, &mut out[first..=last]);
+        }
+        out
+    } else {
+        fft::convolve_same(spectrum, &kernel, half)
+    }
+}
+
+#[cfg(feature = "std")]
+mod fft {
+    use alloc::vec::Vec;
+
+    /// In-place iterative radix-2 FFT of complex sequence with real parts `re` and imaginary parts `im`
+    ///
+    /// Length must be a power of two
+    fn transform(re: &mut [f64], im: &mut [f64], inverse: bool) {
+        let n = re.len();
+        // bit reversal permutation
+        let mut j = 0;
+        for i in 1..n {
+            let mut bit = n >> 1;
+            while j & bit != 0 {
+                j ^= bit;
+                bit >>= 1;
+            }
+            j |= bit;
+            if i < j {
+                re.swap(i, j);
+                im.swap(i, j);
+            }
+        }
+        let sign = if inverse { 1.0 } else { -1.0 };
+        let mut len = 2;
+        while len <= n {
+            let angle = sign * 2.0 * core::f64::consts::PI / len as f64;
+            let (w_im, w_re) = angle.sin_cos();
+            for start in (0..n).step_by(len) {
+                let (mut c_re, mut c_im) = (1.0, 0.0);
+                for k in 0..len / 2 {
+                    let (a, b) = (start + k, start + k + len / 2);
+                    let t_re = re[b] * c_re - im[b] * c_im;
+                    let t_im = re[b] * c_im + im[b] * c_re;
+                    re[b] = re[a] - t_re;
+                    im[b] = im[a] - t_im;
+                    re[a] += t_re;
+                    im[a] += t_im;
+                    (c_re, c_im) = (c_re * w_re - c_im * w_im, c_re * w_im + c_im * w_re);
+                }
+            }
+            len <<= 1;
+        }
+        if inverse {
+            let scale = 1.0 / n as f64;
+            re.iter_mut().chain(im.iter_mut()).for_each(|v| *v *= scale);
+        }
+    }
+
+    /// Linear convolution of `signal` with `kernel` centered at `center`, cropped to `signal` length
+    pub(super) fn convolve_same(signal: &[f64], kernel: &[f64], center: usize) -> Vec<f64> {
+        let n = (signal.len() + kernel.len() - 1).next_power_of_two();
+        let mut a_re = alloc::vec![0.0; n];
+        let mut a_im = alloc::vec![0.0; n];
+        let mut b_re = alloc::vec![0.0; n];
+        let mut b_im = alloc::vec![0.0; n];
+        a_re[..signal.len()].copy_from_slice(signal);
+        b_re[..kernel.len()].copy_from_slice(kernel);
+        transform(&mut a_re, &mut a_im, false);
+        transform(&mut b_re, &mut b_im, false);
+        for i in 0..n {
+            let (re, im) = (
+                a_re[i] * b_re[i] - a_im[i] * b_im[i],
+                a_re[i] * b_im[i] + a_im[i] * b_re[i],
+            );
+            a_re[i] = re;
+            a_im[i] = im;
+        }
+        transform(&mut a_re, &mut a_im, true);
+        a_re[center..center + signal.len()].to_vec()
+    }
+}
@@ -0,0 +1,176 @@
+//! Binned spectra of mixture emissions
+//!
+//! Unsafe: no
+
+use alloc::vec::Vec;
+
+use crate::wrapper::{EnergyCountPair, EnergyRatePair};
+
+mod folding;
+pub use folding::DetectorResponse;
+#[cfg(feature = "std")]
+pub use folding::gaussian_convolve;
+
+mod response;
+pub use response::ResponseMatrix;
+
+#[cfg(feature = "std")]
+mod synthetic;
+#[cfg(feature = "std")]
+pub use synthetic::SyntheticSpectra;
+
+/// Energy binning of a spectrum
+///
+/// Bins are defined by their edges: bin $i$ spans $[e_i; e_{i+1})$. Uniform binnings are detected at construction, and allow $O(1)$ bin lookup
+///
+/// ### Example
+/// ```rust
+/// # use sdecay::spectrum::Binning;
+/// # use sdecay::cst::keV;
+/// let binning = Binning::uniform(0.0, 3000.0 * keV, 1024).unwrap();
+/// assert_eq!(binning.len(), 1024);
+/// assert_eq!(binning.find(1.0 * keV), Some(0));
+/// assert_eq!(binning.find(3000.0 * keV), None);
+/// ```
+#[derive(Debug, Clone, PartialEq)]
+pub struct Binning {
+    edges: Vec<f64>,
+    /// `(first edge, inverse bin width)` for uniform binnings
+    uniform: Option<(f64, f64)>,
+}
+
+impl Binning {
+    /// Creates `bins` equal bins spanning $[min; max)$
+    ///
+    /// ### Returns
+    /// [`Option::None`] if `bins` is zero, or bounds are not finite and increasing
+    pub fn uniform(min: f64, max: f64, bins: usize) -> Option<Self> {
+        if bins == 0 || !(min.is_finite() && max.is_finite() && min < max) {
+            return None;
+        }
+        let width = (max - min) / bins as f64;
+        let mut edges = (0..bins)
+            .map(|i| min + width * i as f64)
+            .collect::<Vec<_>>();
+        edges.push(max);
+        Some(Self {
+            edges,
+            uniform: Some((min, 1.0 / width)),
+        })
+    }
+
+    /// Creates binning from explicit bin `edges`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if there are less than two edges, or they are not finite and strictly increasing
+    pub fn from_edges(edges: impl Into<Vec<f64>>) -> Option<Self> {
+        let edges = edges.into();
+        if edges.len() < 2
+            || edges.iter().any(|e| !e.is_finite())
+            || edges.windows(2).any(|w| w[0] >= w[1])
+        {
+            return None;
+        }
+        Some(Self {
+            edges,
+            uniform: None,
+        })
+    }
+
+    /// Number of bins
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.edges.len() - 1
+    }
+
+    /// Checks if there are no bins (never true for a constructed binning)
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Bin edges, there are [`Binning::len`]` + 1` of them
+    #[inline]
+    pub fn edges(&self) -> &[f64] {
+        &self.edges
+    }
+
+    /// Lower edge of the first bin
+    #[inline]
+    pub fn min(&self) -> f64 {
+        self.edges[0]
+    }
+
+    /// Upper edge of the last bin
+    #[inline]
+    pub fn max(&self) -> f64 {
+        self.edges[self.edges.len() - 1]
+    }
+
+    /// Center of the bin at `index`
+    ///
+    /// ### Panics
+    /// If `index` is out of bounds
+    #[inline]
+    pub fn center(&self, index: usize) -> f64 {
+        0.5 * (self.edges[index] + self.edges[index + 1])
+    }
+
+    /// Finds index of the bin containing `energy`
+    ///
+    /// ### Returns
+    /// [`Option::None`] if energy is outside of the binning (or is NaN)
+    #[inline]
+    pub fn find(&self, energy: f64) -> Option<usize> {
+        if !(energy >= self.min() && energy < self.max()) {
+            return None;
+        }
+        if let Some((min, inv_width)) = self.uniform {
+            // rounding may put energy near the edge into the neighbouring bin
+            let index = (((energy - min) * inv_width) as usize).min(self.len() - 1);
+            return Some(index);
+        }
+        Some(self.edges.partition_point(|&edge| edge <= energy) - 1)
+    }
+
+    /// Adds `lines` (pairs of energy and value) into `spectrum`
+    ///
+    /// Lines outside of the binning are ignored
+    ///
+    /// ### Panics
+    /// If `spectrum` length is not equal to [`Binning::len`]
+    pub fn accumulate(&self, lines: impl IntoIterator<Item = (f64, f64)>, spectrum: &mut [f64]) {
+        assert_eq!(spectrum.len(), self.len(), "spectrum should match binning");
+        for (energy, value) in lines {
+            if let Some(index) = self.find(energy) {
+                spectrum[index] += value;
+            }
+        }
+    }
+
+    /// Histograms `lines` (pairs of energy and value) into a new spectrum
+    pub fn histogram(&self, lines: impl IntoIterator<Item = (f64, f64)>) -> Vec<f64> {
+        let mut spectrum = alloc::vec![0.0; self.len()];
+        self.accumulate(lines, &mut spectrum);
+        spectrum
+    }
+
+    /// Histograms line rates, as returned by [`NuclideMixture::photons`](crate::wrapper::NuclideMixture::photons) and similar functions
+    pub fn histogram_rates(&self, lines: &[EnergyRatePair]) -> Vec<f64> {
+        self.histogram(lines.iter().map(
+            |&EnergyRatePair {
+                 energy,
+                 num_per_second,
+             }| (energy, num_per_second),
+        ))
+    }
+
+    /// Histograms line counts, as returned by [`NuclideMixture::decay_photons_in_interval`](crate::wrapper::NuclideMixture::decay_photons_in_interval) and similar functions
+    pub fn histogram_counts(&self, lines: &[EnergyCountPair]) -> Vec<f64> {
+        self.histogram(
+            lines
+                .iter()
+                .map(|&EnergyCountPair { energy, count }| (energy, count)),
+        )
+    }
+}
@@ -0,0 +1,214 @@
+use alloc::vec::Vec;
+
+use crate::{
+    lines::LineIndex,
+    spectrum::Binning,
+    wrapper::{Nuclide, NuclideActivityPair, NuclideMixture},
+};
+
+/// Sparse nuclide × bin matrix of emission rates per unit activity
+///
+/// Row $n$ is the binned spectrum emitted by nuclide $n$ at unit activity (i.e. it's line intensities, histogrammed). Spectra of many mixtures are then a single sparse-dense product
+/// $$
+/// S = A \cdot R,
+/// $$
+/// where $A$ is a (mixtures × nuclides) activity matrix. Nuclides (matrix columns of $A$) are ordered as in [`ResponseMatrix::nuclides`]
+///
+/// Rows are stored in CSR format, so building spectrum of a mixture only touches bins nuclides actually emit into
+#[derive(Debug, Clone)]
+pub struct ResponseMatrix<'i, 'l> {
+    lines: &'i LineIndex<'l>,
+    bins: usize,
+    row_offsets: Vec<usize>,
+    columns: Vec<u32>,
+    values: Vec<f64>,
+}
+
+impl<'i, 'l> ResponseMatrix<'i, 'l> {
+    /// Builds response matrix for all the nuclides in the `lines` index
+    ///
+    /// Lines outside of the binning are dropped
+    pub fn new(lines: &'i LineIndex<'l>, binning: &Binning) -> Self {
+        let bins = binning.len();
+        let nuclides = lines.nuclides().len();
+        let mut row_offsets = Vec::with_capacity(nuclides + 1);
+        let mut columns = Vec::new();
+        let mut values = Vec::new();
+        for position in 0..nuclides {
+            row_offsets.push(columns.len());
+            let row_start = columns.len();
+            let nuclide_lines = lines.lines_at(position);
+            // lines are sorted by energy, so bins are non-decreasing
+            for (&energy, &intensity) in
+                nuclide_lines.energies.iter().zip(nuclide_lines.intensities)
+            {
+                let Some(bin) = binning.find(energy) else {
+                    continue;
+                };
+                let bin = bin as u32;
+                if columns.len() > row_start && columns.last() == Some(&bin) {
+                    *values.last_mut().expect("lengths are equal") += intensity;
+                } else {
+                    columns.push(bin);
+                    values.push(intensity);
+                }
+            }
+        }
+        row_offsets.push(columns.len());
+        Self {
+            lines,
+            bins,
+            row_offsets,
+            columns,
+            values,
+        }
+    }
+
+    /// Number of bins (matrix columns)
+    #[inline]
+    pub fn bins(&self) -> usize {
+        self.bins
+    }
+
+    /// Nuclides corresponding to matrix rows
+    #[inline]
+    pub fn nuclides(&self) -> &[&'l Nuclide<'l>] {
+        self.lines.nuclides()
+    }
+
+    /// Number of stored (non-zero) matrix elements
+    #[inline]
+    pub fn num_non_zero(&self) -> usize {
+        self.values.len()
+    }
+
+    /// Sparse row of the nuclide at `position`: bin indices and rates per unit activity
+    ///
+    /// ### Panics
+    /// If `position` is out of bounds of [`ResponseMatrix::nuclides`]
+    #[inline]
+    pub fn row(&self, position: usize) -> (&[u32], &[f64]) {
+        let range = self.row_offsets[position]..self.row_offsets[position + 1];
+        (&self.columns[range.clone()], &self.values[range])
+    }
+
+    /// Writes activities of `mixture` at `time` into `row`, in order of [`ResponseMatrix::nuclides`]
+    ///
+    /// Nuclides absent from the matrix are ignored
+    ///
+    /// ### Panics
+    /// If `row` length is not equal to the number of nuclides
+    pub fn activity_row(&self, mixture: &NuclideMixture<'_>, time: f64, row: &mut [f64]) {
+        assert_eq!(
+            row.len(),
+            self.nuclides().len(),
+            "row should match nuclides"
+        );
+        row.fill(0.0);
+        let mut tmp = core::mem::MaybeUninit::uninit();
+        let activities = mixture.activities_local(&mut tmp, time);
+        for &NuclideActivityPair { nuclide, activity } in &activities {
+            if let Some(position) = self.lines.position(nuclide) {
+                row[position] += activity;
+            }
+        }
+    }
+
+    /// Builds (mixtures × nuclides) activity matrix for `mixtures` at `time`
+    pub fn activity_matrix<'m>(
+        &self,
+        mixtures: impl IntoIterator<Item = &'m NuclideMixture<'m>>,
+        time: f64,
+    ) -> Vec<f64> {
+        let nuclides = self.nuclides().len();
+        let mut matrix = Vec::new();
+        for mixture in mixtures {
+            let start = matrix.len();
+            matrix.resize(start + nuclides, 0.0);
+            self.activity_row(mixture, time, &mut matrix[start..]);
+        }
+        matrix
+    }
+
+    /// Accumulates spectrum for a single `activities` row into `spectrum`
+    ///
+    /// ### Panics
+    /// If lengths do not match matrix dimensions
+    pub fn spectrum_into(&self, activities: &[f64], spectrum: &mut [f64]) {
+        assert_eq!(
+            activities.len(),
+            self.nuclides().len(),
+            "activities should match nuclides"
+        );
+        assert_eq!(spectrum.len(), self.bins, "spectrum should match bins");
+        for (position, &activity) in activities.iter().enumerate() {
+            if activity == 0.0 {
+                continue;
+            }
+            let (columns, values) = self.row(position);
+            for (&column, &value) in columns.iter().zip(values) {
+                spectrum[column as usize] += activity * value;
+            }
+        }
+    }
+
+    /// Computes spectra for every row of (mixtures × nuclides) `activities` matrix, writing them into (mixtures × bins) `spectra`
+    ///
+    /// `spectra` is overwritten
+    ///
+    /// ### Panics
+    /// If lengths do not match matrix dimensions
+    pub fn spectra_into(&self, activities: &[f64], spectra: &mut [f64]) {
+        let nuclides = self.nuclides().len();
+        if nuclides == 0 || self.bins == 0 {
+            spectra.fill(0.0);
+            return;
+        }
+        assert_eq!(
+            activities.len() % nuclides,
+            0,
+            "activities should match nuclides"
+        );
+        assert_eq!(
+            spectra.len(),
+            activities.len() / nuclides * self.bins,
+            "spectra should match activities and bins"
+        );
+        spectra.fill(0.0);
+        for (activities, spectrum) in activities
+            .chunks_exact(nuclides)
+            .zip(spectra.chunks_exact_mut(self.bins))
+        {
+            self.spectrum_into(activities, spectrum);
+        }
+    }
+
+    /// Same as [`ResponseMatrix::spectra_into`], but allocates the output
+    pub fn spectra(&self, activities: &[f64]) -> Vec<f64> {
+        let mixtures = activities
+            .len()
+            .checked_div(self.nuclides().len())
+            .unwrap_or(0);
+        let mut spectra = alloc::vec![0.0; mixtures * self.bins];
+        self.spectra_into(activities, &mut spectra);
+        spectra
+    }
+
+    /// Same as [`ResponseMatrix::spectra`], but splits mixtures between `threads` threads
+    #[cfg(feature = "std")]
+    pub fn spectra_parallel(&self, activities: &[f64], threads: usize) -> Vec<f64> {
+        let nuclides = self.nuclides().len();
+        let mixtures = activities.len().checked_div(nuclides).unwrap_or(0);
+        let mut spectra = alloc::vec![0.0; mixtures * self.bins];
+        if mixtures == 0 || self.bins == 0 {
+            return spectra;
+        }
+        crate::parallel::for_each_mut(&mut spectra, self.bins, threads, |mixtures, spectra| {
+            self.spectra_into(
+                &activities[mixtures.start * nuclides..mixtures.end * nuclides],
+                spectra,
+            );
+        });
+        spectra
+    }
+}
@@ -0,0 +1,105 @@
+use alloc::vec::Vec;
+
+use crate::{
+    random::{Poisson, Rng},
+    spectrum::Binning,
+    wrapper::{HowToOrder, NuclideMixture},
+};
+
+/// Generator of Poisson-noised spectra around a fixed expected spectrum
+///
+/// Expected spectrum and per-bin [`Poisson`] samplers are computed once, at construction. Realizations are written into a single contiguous buffer, realization-major (i.e. each spectrum is contiguous)
+///
+/// Realization number `i` is always sampled with [`Rng::for_index`]`(seed, i)`, so output only depends on the `seed`, and not on a number of threads used
+#[derive(Debug, Clone)]
+pub struct SyntheticSpectra {
+    expected: Vec<f64>,
+    samplers: Vec<Poisson>,
+}
+
+impl SyntheticSpectra {
+    /// Creates generator from expected counts in each bin
+    pub fn new(expected: Vec<f64>) -> Self {
+        let samplers = expected.iter().copied().map(Poisson::new).collect();
+        Self { expected, samplers }
+    }
+
+    /// Creates generator for photons emitted by `mixture` over `live_time`, starting at mixture's age `initial_age`
+    ///
+    /// Expected counts are obtained from a single [`NuclideMixture::decay_photons_in_interval`] call, see it's doc for `characteristic_time_slices` meaning
+    pub fn for_mixture(
+        mixture: &NuclideMixture<'_>,
+        initial_age: f64,
+        live_time: f64,
+        binning: &Binning,
+        characteristic_time_slices: usize,
+    ) -> Self {
+        let mut tmp = core::mem::MaybeUninit::uninit();
+        let counts = mixture.decay_photons_in_interval_local(
+            &mut tmp,
+            initial_age,
+            live_time,
+            HowToOrder::OrderByEnergy,
+            characteristic_time_slices,
+        );
+        Self::new(binning.histogram_counts(counts.as_slice()))
+    }
+
+    /// Number of bins in each spectrum
+    #[inline]
+    pub fn bins(&self) -> usize {
+        self.expected.len()
+    }
+
+    /// Expected (noiseless) spectrum
+    #[inline]
+    pub fn expected(&self) -> &[f64] {
+        &self.expected
+    }
+
+    /// Writes realizations `first_realization..` into `out`, that should contain a whole number of spectra
+    ///
+    /// Counts exceeding [`u32::MAX`] are saturated
+    ///
+    /// ### Panics
+    /// If `out` length is not a multiple of [`SyntheticSpectra::bins`]
+    pub fn generate_into(&self, seed: u64, first_realization: u64, out: &mut [u32]) {
+        let bins = self.bins();
+        if bins == 0 {
+            return;
+        }
+        assert_eq!(
+            out.len() % bins,
+            0,
+            "output should contain whole number of spectra"
+        );
+        for (realization, spectrum) in (first_realization..).zip(out.chunks_exact_mut(bins)) {
+            let mut rng = Rng::for_index(seed, realization);
+            for (count, sampler) in spectrum.iter_mut().zip(&self.samplers) {
+                *count = u32::try_from(sampler.sample(&mut rng)).unwrap_or(u32::MAX);
+            }
+        }
+    }
+
+    /// Generates `realizations` spectra in a single buffer
+    pub fn generate(&self, seed: u64, realizations: usize) -> Vec<u32> {
+        let mut out = alloc::vec![0; realizations * self.bins()];
+        self.generate_into(seed, 0, &mut out);
+        out
+    }
+
+    /// Same as [`SyntheticSpectra::generate`], but splits realizations between `threads` threads
+    ///
+    /// Output is identical to the one of [`SyntheticSpectra::generate`] with the same `seed`
+    pub fn generate_parallel(&self, seed: u64, realizations: usize, threads: usize) -> Vec<u32> {
+        let bins = self.bins();
+        let mut out = alloc::vec![0; realizations * bins];
+        if bins == 0 || realizations == 0 {
+            return out;
+        }
+        crate::parallel::for_each_mut(&mut out, bins, threads, |realizations, out| {
+            self.generate_into(seed, realizations.start as u64, out);
+        });
+        out
+    }
+}
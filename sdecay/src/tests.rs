@@ -417,3 +417,1865 @@ mod mixture {
         println!("{}", exception.what_str());
     }
 }
+
+#[cfg(feature = "alloc")]
+mod coincidence {
+    use approx::assert_relative_eq;
+
+    use crate::{coincidence::CoincidenceTable, cst::Ci};
+
+    use super::*;
+
+    #[test]
+    fn co60_table() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let table = CoincidenceTable::from_nuclides([co60]);
+        let coincidences = table.get(co60).expect("Co60 has gamma lines");
+        assert!(coincidences.lines().len() >= 2);
+        for index in 0..coincidences.lines().len() {
+            for (column, fraction) in coincidences.coincident_with(index) {
+                assert!(column < coincidences.lines().len());
+                assert!((0.0..=1.0).contains(&fraction));
+            }
+        }
+        let h3 = db.nuclide(nuclide!(H - 3));
+        assert!(table.get(h3).is_none());
+    }
+
+    #[test]
+    fn no_total_efficiency_no_summing_out() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let table = CoincidenceTable::from_nuclides([co60]);
+        let corrections = table.with_efficiencies(&|_| 0.1, &|_| 0.0, 1.0);
+        let activity = 1e-6 * Ci;
+        for correction in corrections.corrections_for([(co60, activity)]) {
+            assert_eq!(correction.summing_out_rate, 0.0);
+            assert_relative_eq!(correction.peak_rate, 0.1 * correction.rate);
+        }
+    }
+
+    #[test]
+    fn cascade_summing() {
+        use crate::coincidence::{CoincidenceLine, CoincidenceMatrix};
+
+        let line = |energy, intensity| CoincidenceLine { energy, intensity };
+        let lines = || vec![line(100.0, 0.5), line(200.0, 0.8), line(300.0, 0.01)];
+        let peak = [0.1, 0.2, 0.3];
+        let total = [0.4, 0.5, 0.6];
+
+        // 100 + 200 cascade, listed in the row of the higher-index line only
+        let matrix = CoincidenceMatrix::from_rows(lines(), &[&[], &[(0, 0.6)], &[]]);
+        let mut summing_in = [0.0; 3];
+        let mut summing_out = Vec::new();
+        matrix.summing(&peak, &total, 1e-6, &mut summing_in, &mut summing_out);
+        assert_eq!(summing_out, [1.0, 1.0 - 0.6 * 0.4, 1.0]);
+        // I_k c_kj eps_j eps_k
+        assert_eq!(summing_in[..2], [0.0, 0.0]);
+        assert_relative_eq!(summing_in[2], 0.8 * 0.6 * 0.1 * 0.2, max_relative = 1e-15);
+
+        // same cascade, listed in both rows: summed in once, from the lower-index row
+        let matrix = CoincidenceMatrix::from_rows(lines(), &[&[(1, 0.96)], &[(0, 0.6)], &[]]);
+        let mut summing_in = [0.0; 3];
+        let mut summing_out = Vec::new();
+        matrix.summing(&peak, &total, 1e-6, &mut summing_in, &mut summing_out);
+        assert_eq!(summing_out, [1.0 - 0.96 * 0.5, 1.0 - 0.6 * 0.4, 1.0]);
+        assert_eq!(summing_in[..2], [0.0, 0.0]);
+        assert_relative_eq!(summing_in[2], 0.5 * 0.96 * 0.1 * 0.2, max_relative = 1e-15);
+    }
+
+    #[test]
+    fn co60_summing_out() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let table = CoincidenceTable::from_nuclides([co60]);
+        let has_coincidences = table.get(co60).unwrap().num_coincidences() > 0;
+        let corrections = table.with_efficiencies(&|_| 0.05, &|_| 0.2, 1.0);
+        let factors = corrections.nuclide_factors(co60).unwrap();
+
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        let activity = 1e-6 * Ci;
+        mx.add_nuclide_by_activity(co60, activity);
+        let lines = corrections.corrections(&mx, 0.0);
+        assert_eq!(lines.len(), factors.len());
+        for (line, factor) in lines.iter().zip(factors) {
+            assert_relative_eq!(line.factor(), factor, max_relative = 1e-9);
+            // 1332 keV line is not fed by any summing pair
+            if (line.energy - 1332.5).abs() < 1.0 && has_coincidences {
+                assert!(line.factor() < 1.0);
+            }
+        }
+    }
+}
+
+mod random {
+    use crate::random::Rng;
+
+    #[test]
+    fn reproducible() {
+        let mut a = Rng::new(7);
+        let mut b = Rng::new(7);
+        for _ in 0..100 {
+            assert_eq!(a.next_u64(), b.next_u64());
+        }
+    }
+
+    #[test]
+    fn streams_differ() {
+        let mut a = Rng::stream(7, 0);
+        let mut b = Rng::stream(7, 1);
+        assert_ne!(a.next_u64(), b.next_u64());
+    }
+
+    #[test]
+    #[cfg(feature = "alloc")]
+    fn alias_table_frequencies() {
+        use crate::random::AliasTable;
+
+        let weights = [1.0, 2.0, 0.0, 5.0];
+        let table = AliasTable::new(&weights).unwrap();
+        let mut rng = Rng::new(1);
+        let mut counts = [0usize; 4];
+        let n = 200_000;
+        for _ in 0..n {
+            counts[table.sample(&mut rng)] += 1;
+        }
+        assert_eq!(counts[2], 0);
+        for (count, weight) in counts.iter().zip(weights) {
+            let expected = weight / 8.0;
+            assert!((*count as f64 / n as f64 - expected).abs() < 0.01);
+        }
+        assert!(AliasTable::new(&[]).is_none());
+        assert!(AliasTable::new(&[0.0, 0.0]).is_none());
+        assert!(AliasTable::new(&[1.0, -1.0]).is_none());
+    }
+}
+
+#[cfg(feature = "alloc")]
+mod event_generator {
+    use crate::{
+        cst::Ci,
+        event_generator::{EventBuffer, EventGenerator},
+        random::Rng,
+    };
+
+    use super::*;
+
+    #[test]
+    fn co60_events() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let h3 = db.nuclide(nuclide!(H - 3));
+        let generator = EventGenerator::from_activities([(co60, 1e-6 * Ci), (h3, 0.0)]);
+        assert_eq!(generator.nuclides().len(), 1);
+
+        let mut rng = Rng::new(3);
+        let mut buffer = EventBuffer::new();
+        let n = 10_000;
+        assert_eq!(generator.generate(&mut rng, n, &mut buffer), n);
+        assert_eq!(buffer.events.len(), n);
+
+        let transitions = co60.decays_to_children.as_slice();
+        let mean_particles = transitions
+            .iter()
+            .map(|t| {
+                f64::from(t.branch_ratio)
+                    * t.products
+                        .as_slice()
+                        .iter()
+                        .map(|p| f64::from(p.intensity))
+                        .sum::<f64>()
+            })
+            .sum::<f64>();
+        for event in &buffer.events {
+            assert_eq!(event.nuclide, 0);
+            let transition = transitions[event.transition as usize];
+            for particle in buffer.particles_of(event) {
+                let product = &transition.products[particle.product as usize];
+                assert_eq!(product.energy, particle.energy);
+            }
+        }
+        let sampled_mean = buffer.particles.len() as f64 / n as f64;
+        assert!((sampled_mean - mean_particles).abs() < 0.05 * mean_particles.max(1.0));
+    }
+
+    #[test]
+    fn one_branch_per_transition() {
+        use crate::wrapper::ProductTypeD;
+
+        database!(db);
+        let u238 = db.nuclide(nuclide!(U - 238));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_in_prompt_equilibrium(u238, 1e-6 * Ci);
+        let generator = EventGenerator::new(&mx, 0.0);
+
+        let mut rng = Rng::new(5);
+        let mut buffer = EventBuffer::new();
+        generator.generate(&mut rng, 20_000, &mut buffer);
+        for event in &buffer.events {
+            let nuclide = generator.nuclides()[event.nuclide as usize];
+            let transition = nuclide.decays_to_children[event.transition as usize];
+            let particles = buffer.particles_of(event);
+            let branches = particles
+                .iter()
+                .filter(|particle| {
+                    matches!(
+                        particle.r#type.d(),
+                        ProductTypeD::BetaParticle
+                            | ProductTypeD::PositronParticle
+                            | ProductTypeD::AlphaParticle
+                            | ProductTypeD::CaptureElectronParticle
+                    )
+                })
+                .count();
+            assert!(branches <= 1, "{branches} branches in {}", nuclide.symbol);
+            for (i, particle) in particles.iter().enumerate() {
+                if transition.products[particle.product as usize].intensity <= 1.0 {
+                    assert!(
+                        particles[i + 1..]
+                            .iter()
+                            .all(|other| other.product != particle.product),
+                        "line emitted twice in {}",
+                        nuclide.symbol
+                    );
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn empty_generator() {
+        let generator = EventGenerator::from_activities([]);
+        let mut rng = Rng::new(0);
+        let mut buffer = EventBuffer::new();
+        assert_eq!(generator.generate(&mut rng, 10, &mut buffer), 0);
+        assert!(buffer.events.is_empty());
+    }
+
+    #[test]
+    #[cfg(feature = "std")]
+    fn parallel_reproducible() {
+        database!(db);
+        let u238 = db.nuclide(nuclide!(U - 238));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_in_prompt_equilibrium(u238, 1e-6 * Ci);
+        let generator = EventGenerator::new(&mx, 0.0);
+        let a = generator.generate_parallel(11, 1001, 4);
+        let b = generator.generate_parallel(11, 1001, 4);
+        assert_eq!(a.len(), 4);
+        assert_eq!(a.iter().map(|b| b.events.len()).sum::<usize>(), 1001);
+        for (a, b) in a.iter().zip(&b) {
+            assert_eq!(a.events, b.events);
+            assert_eq!(a.particles, b.particles);
+        }
+    }
+}
+
+#[cfg(feature = "alloc")]
+mod spectrum {
+    use crate::spectrum::Binning;
+
+    #[test]
+    fn uniform_find() {
+        let binning = Binning::uniform(0.0, 10.0, 10).unwrap();
+        assert_eq!(binning.find(-0.1), None);
+        assert_eq!(binning.find(0.0), Some(0));
+        assert_eq!(binning.find(9.999), Some(9));
+        assert_eq!(binning.find(10.0), None);
+        assert_eq!(binning.find(f64::NAN), None);
+        assert!(Binning::uniform(1.0, 1.0, 10).is_none());
+    }
+
+    #[test]
+    fn edges_find() {
+        let binning = Binning::from_edges([0.0, 1.0, 5.0, 6.0]).unwrap();
+        assert_eq!(binning.len(), 3);
+        assert_eq!(binning.find(0.5), Some(0));
+        assert_eq!(binning.find(1.0), Some(1));
+        assert_eq!(binning.find(5.5), Some(2));
+        assert!(Binning::from_edges([0.0, 2.0, 1.0]).is_none());
+        let spectrum = binning.histogram([(0.5, 1.0), (0.7, 2.0), (5.5, 3.0), (7.0, 4.0)]);
+        assert_eq!(spectrum, [3.0, 0.0, 3.0]);
+    }
+
+    fn toy_response(bin: usize, column: &mut [f64]) {
+        // full-energy peak plus flat continuum below it
+        column[bin] = 0.5;
+        column[..bin].fill(0.01);
+    }
+
+    #[test]
+    fn dense_matches_banded() {
+        use crate::spectrum::DetectorResponse;
+
+        let binning = Binning::uniform(0.0, 2000.0, 1100).unwrap();
+        let dense = DetectorResponse::dense(binning.clone(), 1100, toy_response);
+        let banded = DetectorResponse::banded(binning.clone(), 1100, toy_response);
+        let lines = [(100.0, 2.0), (1500.0, 1.0), (1999.0, 3.0), (2500.0, 7.0)];
+        let mut a = vec![0.0; 1100];
+        let mut b = vec![0.0; 1100];
+        dense.fold_lines(lines, &mut a);
+        banded.fold_lines(lines, &mut b);
+        assert_eq!(a, b);
+
+        let input = binning.histogram(lines);
+        let mut c = vec![0.0; 1100];
+        let mut d = vec![0.0; 1100];
+        dense.fold_spectrum(&input, &mut c);
+        banded.fold_spectrum(&input, &mut d);
+        assert_eq!(a, c);
+        assert_eq!(a, d);
+        assert_eq!(a[binning.find(1500.0).unwrap()], 0.5 + 3.0 * 0.01);
+    }
+
+    #[test]
+    fn dense_partial_block() {
+        use crate::spectrum::DetectorResponse;
+
+        // two full channel blocks, and a narrow one
+        let channels = 2 * 512 + 6;
+        let binning = Binning::uniform(0.0, 3.0, 3).unwrap();
+        let response = |bin: usize, column: &mut [f64]| {
+            for (channel, value) in column.iter_mut().enumerate() {
+                *value = (bin * channels + channel) as f64;
+            }
+        };
+        let dense = DetectorResponse::dense(binning.clone(), channels, response);
+        let mut expected = vec![0.0; channels];
+        for bin in 0..3 {
+            let mut out = vec![0.0; channels];
+            dense.fold_lines([(bin as f64 + 0.5, 1.0)], &mut out);
+            response(bin, &mut expected);
+            assert_eq!(out, expected, "bin {bin}");
+        }
+        let mut out = vec![0.0; channels];
+        dense.fold_spectrum(&[1.0, 0.0, 2.0], &mut out);
+        for (channel, out) in out.iter().enumerate() {
+            assert_eq!(*out, (channel + 2 * (2 * channels + channel)) as f64);
+        }
+    }
+
+    #[cfg(feature = "std")]
+    #[test]
+    fn gaussian_fft_matches_direct() {
+        use crate::spectrum::gaussian_convolve;
+
+        let spectrum = (0..4096)
+            .map(|i| f64::from((i * 7919) % 13))
+            .collect::<Vec<_>>();
+        let sigma = 50.0;
+        let broadened = gaussian_convolve(&spectrum, sigma);
+        // direct, with the same truncated kernel
+        let half = 250_i64;
+        let norm: f64 = (-half..=half)
+            .map(|k| (-0.5 * (k as f64 / sigma).powi(2)).exp())
+            .sum();
+        for i in [0_i64, 17, 2048, 4095] {
+            let direct: f64 = (-half..=half)
+                .filter_map(|k| spectrum.get(usize::try_from(i - k).ok()?).map(|v| (k, v)))
+                .map(|(k, v)| v * (-0.5 * (k as f64 / sigma).powi(2)).exp() / norm)
+                .sum();
+            assert!((broadened[i as usize] - direct).abs() < 1e-9, "channel {i}");
+        }
+        assert_eq!(gaussian_convolve(&spectrum, 0.0), spectrum);
+    }
+
+    #[cfg(feature = "std")]
+    mod synthetic {
+        use crate::{
+            cst::{Ci, keV, second},
+            spectrum::{Binning, SyntheticSpectra},
+        };
+
+        use super::super::*;
+
+        #[test]
+        fn poisson_mean() {
+            let generator = SyntheticSpectra::new(vec![0.0, 0.5, 4.0, 50.0, 1e4]);
+            let realizations = 4000;
+            let spectra = generator.generate(1, realizations);
+            assert_eq!(spectra.len(), realizations * 5);
+            for (bin, &expected) in generator.expected().iter().enumerate() {
+                let mean = spectra
+                    .iter()
+                    .skip(bin)
+                    .step_by(5)
+                    .map(|&c| f64::from(c))
+                    .sum::<f64>()
+                    / realizations as f64;
+                let sigma = (expected / realizations as f64).sqrt();
+                assert!((mean - expected).abs() <= 5.0 * sigma + 1e-9, "bin {bin}");
+            }
+        }
+
+        #[test]
+        fn parallel_matches_serial() {
+            let generator = SyntheticSpectra::new(vec![1.0, 20.0, 300.0]);
+            let serial = generator.generate(5, 101);
+            let parallel = generator.generate_parallel(5, 101, 7);
+            assert_eq!(serial, parallel);
+        }
+
+        #[test]
+        fn co60_spectrum() {
+            database!(db);
+            let co60 = db.nuclide(nuclide!(Co - 60));
+            let mut tmp = MaybeUninit::uninit();
+            let mut mx = crate::LocalMixture::new_in(&mut tmp);
+            mx.add_nuclide_by_activity(co60, 1e-6 * Ci);
+            let binning = Binning::uniform(0.0, 3000.0 * keV, 3000).unwrap();
+            let generator = SyntheticSpectra::for_mixture(&mx, 0.0, 10.0 * second, &binning, 50);
+            let peak = binning.find(1332.5 * keV).unwrap();
+            assert!(generator.expected()[peak] > 0.0);
+            let spectra = generator.generate(0, 3);
+            assert_eq!(spectra.len(), 3 * 3000);
+        }
+    }
+}
+
+#[cfg(feature = "alloc")]
+mod lines {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{Ci, keV},
+        lines::{LineIndex, LineSelection},
+        spectrum::{Binning, ResponseMatrix},
+        wrapper::HowToOrder,
+    };
+
+    use super::*;
+
+    #[test]
+    fn sorted_lines() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let index = LineIndex::from_nuclides([co60, co60], LineSelection::GAMMAS);
+        assert_eq!(index.nuclides().len(), 1);
+        let lines = index.lines(co60).unwrap();
+        assert!(lines.energies.windows(2).all(|w| w[0] < w[1]));
+    }
+
+    #[test]
+    fn response_matches_photons() {
+        database!(db);
+        let cs137 = db.nuclide(nuclide!(Cs - 137));
+        let ba137m = db.nuclide("Ba137m");
+        let index = LineIndex::from_nuclides([cs137, ba137m], LineSelection::PHOTONS);
+        let binning = Binning::uniform(0.0, 2000.0 * keV, 200).unwrap();
+        let response = ResponseMatrix::new(&index, &binning);
+
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_in_secular_equilibrium(cs137, 1e-6 * Ci)
+            .unwrap();
+        let activities = response.activity_matrix([&*mx, &*mx], 0.0);
+        let spectra = response.spectra(&activities);
+        assert_eq!(spectra.len(), 2 * 200);
+
+        let mut tmp = MaybeUninit::uninit();
+        let photons = mx.photons_local(&mut tmp, 0.0, HowToOrder::OrderByEnergy);
+        let expected = binning.histogram_rates(photons.as_slice());
+        for (a, b) in spectra[..200].iter().zip(&expected) {
+            assert_relative_eq!(*a, *b, max_relative = 1e-6, epsilon = 1e-9);
+        }
+        assert_eq!(&spectra[..200], &spectra[200..]);
+
+        #[cfg(feature = "std")]
+        assert_eq!(response.spectra_parallel(&activities, 3), spectra);
+    }
+
+    #[cfg(feature = "std")]
+    #[test]
+    fn weighted_lines() {
+        use crate::weighting::{LogLogSpline, Weighting};
+
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let index = LineIndex::from_nuclides([co60], LineSelection::GAMMAS);
+        let efficiency = LogLogSpline::new(&[
+            (100.0 * keV, 0.3),
+            (1000.0 * keV, 0.05),
+            (3000.0 * keV, 0.02),
+        ])
+        .unwrap();
+        let mu = LogLogSpline::new(&[(100.0 * keV, 2.0), (3000.0 * keV, 0.4)]).unwrap();
+        let weighting = Weighting::new()
+            .with_efficiency(efficiency.clone())
+            .with_absorber(mu.clone(), 0.5);
+        let weighted = index.weighted(&weighting);
+        let (lines, weighted_lines) = (index.lines(co60).unwrap(), weighted.lines(co60).unwrap());
+        assert_eq!(lines.energies, weighted_lines.energies);
+        for ((&energy, &intensity), &weighted) in lines
+            .energies
+            .iter()
+            .zip(lines.intensities)
+            .zip(weighted_lines.intensities)
+        {
+            let expected =
+                intensity * efficiency.evaluate(energy) * (-0.5 * mu.evaluate(energy)).exp();
+            assert_relative_eq!(weighted, expected, max_relative = 1e-12);
+        }
+        // knots are reproduced, range is clamped
+        assert_relative_eq!(
+            efficiency.evaluate(1000.0 * keV),
+            0.05,
+            max_relative = 1e-12
+        );
+        assert_relative_eq!(efficiency.evaluate(1e4 * keV), 0.02, max_relative = 1e-12);
+        assert!(LogLogSpline::new(&[(1.0, 1.0), (1.0, 2.0)]).is_none());
+    }
+}
+
+#[cfg(feature = "alloc")]
+mod roi {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{Ci, hour, keV},
+        lines::LineIndex,
+        roi::RoiIndex,
+        wrapper::HowToOrder,
+    };
+
+    use super::*;
+
+    const WINDOWS: [core::ops::Range<f64>; 3] = [
+        1160.0 * keV..1180.0 * keV,
+        1320.0 * keV..1340.0 * keV,
+        0.0..3000.0 * keV,
+    ];
+
+    fn window_sums(lines: impl IntoIterator<Item = (f64, f64)> + Clone) -> [f64; 3] {
+        WINDOWS.map(|window| {
+            lines
+                .clone()
+                .into_iter()
+                .filter(|(energy, _)| window.contains(energy))
+                .map(|(_, value)| value)
+                .sum()
+        })
+    }
+
+    #[test]
+    fn rates_match_photons() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let cs137 = db.nuclide(nuclide!(Cs - 137));
+        let lines = LineIndex::photons(db);
+        let roi = RoiIndex::new(&lines, &WINDOWS);
+
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(co60, 1e-6 * Ci);
+        mx.add_nuclide_in_secular_equilibrium(cs137, 2e-6 * Ci)
+            .unwrap();
+        let time = 3.0 * hour;
+        let mut rates = [0.0; 3];
+        roi.rates(&mx, time, &mut rates);
+
+        let mut tmp = MaybeUninit::uninit();
+        let photons = mx.photons_local(&mut tmp, time, HowToOrder::OrderByEnergy);
+        let expected = window_sums(
+            photons
+                .as_slice()
+                .iter()
+                .map(|pair| (pair.energy, pair.num_per_second)),
+        );
+        for (a, b) in rates.iter().zip(&expected) {
+            assert_relative_eq!(*a, *b, max_relative = 1e-6);
+        }
+        assert!(rates[0] > 0.0 && rates[1] > 0.0);
+    }
+
+    #[cfg(feature = "std")]
+    #[test]
+    fn counts_match_interval() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let lines = LineIndex::photons(db);
+        let roi = RoiIndex::new(&lines, &WINDOWS);
+
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(co60, 1e-6 * Ci);
+        let mut counts = [0.0; 3];
+        roi.counts(&mx, hour, 10.0 * hour, &mut counts);
+
+        let mut tmp = MaybeUninit::uninit();
+        let photons = mx.decay_photons_in_interval_local(
+            &mut tmp,
+            hour,
+            10.0 * hour,
+            HowToOrder::OrderByEnergy,
+            100,
+        );
+        let expected = window_sums(
+            photons
+                .as_slice()
+                .iter()
+                .map(|pair| (pair.energy, pair.count)),
+        );
+        for (a, b) in counts.iter().zip(&expected) {
+            assert_relative_eq!(*a, *b, max_relative = 1e-4);
+        }
+    }
+}
+
+#[cfg(feature = "alloc")]
+mod decay_heat {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{Ci, keV, year},
+        decay_heat::{DecayHeatTable, RadiationClass},
+    };
+
+    use super::*;
+
+    #[test]
+    fn co60_energy_per_decay() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let table = DecayHeatTable::from_nuclides([co60], DecayHeatTable::DEFAULT_BETA_FRACTION);
+        let energies = table.energy_per_decay(co60).unwrap();
+        // two gammas of ~1.17 and ~1.33 MeV per decay
+        assert_relative_eq!(
+            energies[RadiationClass::Gamma],
+            2505.7 * keV,
+            max_relative = 1e-2
+        );
+        assert_eq!(energies[RadiationClass::Alpha], 0.0);
+        assert!(energies[RadiationClass::Beta] > 0.0);
+        assert_relative_eq!(
+            energies.total(),
+            energies.photons() + energies.charged(),
+            max_relative = 1e-12
+        );
+    }
+
+    #[test]
+    fn mixture_power() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let table = DecayHeatTable::new(db);
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(co60, 1.0 * Ci);
+        let per_decay = table.energy_per_decay(co60).unwrap();
+        let power = table.power(&mx, 0.0);
+        assert_relative_eq!(power.total(), per_decay.total() * Ci, max_relative = 1e-9);
+
+        #[cfg(feature = "std")]
+        {
+            let times = [0.0, 1.0 * year, 5.0 * year];
+            let curve = table.power_curve(&mx, &times);
+            for (heat, &time) in curve.iter().zip(&times) {
+                assert_relative_eq!(
+                    heat.total(),
+                    table.power(&mx, time).total(),
+                    max_relative = 1e-6
+                );
+            }
+            let energy = table.energy_curve(&mx, &times);
+            assert_eq!(energy.len(), 2);
+            // power decreases, so mean power is bracketed by end points
+            let mean = energy[0].total() / (1.0 * year);
+            assert!(curve[1].total() < mean && mean < curve[0].total());
+        }
+    }
+}
+
+#[cfg(feature = "alloc")]
+mod dose {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{Ci, keV, m, year},
+        dose::DoseRateTable,
+        lines::{LineIndex, LineSelection},
+    };
+
+    use super::*;
+
+    #[test]
+    fn co60_constant() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let cs137 = db.nuclide(nuclide!(Cs - 137));
+        let lines = LineIndex::from_nuclides([co60, cs137], LineSelection::GAMMAS);
+        // dose coefficient proportional to energy: constant is total gamma energy per decay
+        let table = DoseRateTable::new(&lines, &|energy: f64| energy);
+        assert_relative_eq!(
+            table.constant(co60).unwrap(),
+            2505.7 * keV,
+            max_relative = 1e-2
+        );
+        let shielded =
+            DoseRateTable::with_attenuation(&lines, &|energy: f64| energy, &|_: f64| 0.5);
+        assert_relative_eq!(
+            shielded.constant(co60).unwrap(),
+            0.5 * table.constant(co60).unwrap(),
+            max_relative = 1e-12
+        );
+
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(co60, 1.0 * Ci);
+        let strength = table.source_strength(&mx, 0.0);
+        assert_relative_eq!(
+            strength,
+            table.constant(co60).unwrap() * Ci,
+            max_relative = 1e-9
+        );
+        assert_relative_eq!(
+            table.dose_rate(&mx, 0.0, 1.0 * m) * 4.0 * core::f64::consts::PI * m * m,
+            strength,
+            max_relative = 1e-12
+        );
+
+        let position = lines.position(co60).unwrap();
+        let mut activities = vec![0.0; 2 * 2];
+        activities[position] = 1.0 * Ci;
+        activities[2 + position] = 2.0 * Ci;
+        let mut strengths = [0.0; 2];
+        table.source_strengths_into(&activities, &mut strengths);
+        assert_relative_eq!(strengths[1], 2.0 * strength, max_relative = 1e-12);
+
+        #[cfg(feature = "std")]
+        {
+            assert_eq!(table.source_strengths_parallel(&activities, 2), strengths);
+            let curve = table.source_strength_curve(&mx, &[0.0, 5.27 * year]);
+            assert_relative_eq!(curve[0], strength, max_relative = 1e-6);
+            assert_relative_eq!(curve[1], 0.5 * strength, max_relative = 1e-2);
+        }
+    }
+}
+
+#[cfg(feature = "std")]
+mod num_decays {
+    use approx::assert_relative_eq;
+
+    use crate::cst::{Ci, day, year};
+
+    use super::*;
+
+    #[test]
+    fn co60_half_life() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(co60, 1.0 * Ci);
+        let decays = mx.num_decays(0.0, co60.half_life, co60).unwrap();
+        assert_relative_eq!(
+            decays,
+            0.5 * Ci / co60.decay_constant(),
+            max_relative = 1e-9
+        );
+        // short interval: activity times duration
+        let decays = mx.num_decays(year, year + 1.0, co60).unwrap();
+        assert_relative_eq!(decays, mx.total_activity(year), max_relative = 1e-6);
+    }
+
+    #[test]
+    fn branching_chain_batched() {
+        database!(db);
+        let cs137 = db.nuclide(nuclide!(Cs - 137));
+        let ba137m = db.nuclide("Ba137m");
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(cs137, 1.0 * Ci);
+        let intervals = [(0.0, 1.0 * day), (1.0 * day, 1.0 * year), (0.0, 1.0 * year)];
+        let nuclides = mx.num_solution_nuclides();
+        let mut decays = vec![0.0; intervals.len() * nuclides];
+        mx.num_decays_in_intervals_into(&intervals, &mut decays);
+        let mut single = vec![0.0; nuclides];
+        for (&(t0, t1), batched) in intervals.iter().zip(decays.chunks_exact(nuclides)) {
+            mx.num_decays_into(t0, t1, &mut single);
+            assert_eq!(single, batched);
+        }
+        let position = mx
+            .solution_nuclides()
+            .position(|nuclide| core::ptr::eq(nuclide, ba137m))
+            .unwrap();
+        let whole = decays[2 * nuclides + position];
+        let parts = decays[position] + decays[nuclides + position];
+        assert_relative_eq!(whole, parts, max_relative = 1e-9);
+        // Ba137m is fed by ~94.6% of Cs137 decays, and is in equilibrium after a day
+        let ratio = whole / mx.num_decays(0.0, 1.0 * year, cs137).unwrap();
+        assert_relative_eq!(
+            ratio,
+            cs137.branching_ratio_to_descendant(ba137m).into(),
+            max_relative = 1e-3
+        );
+    }
+}
+
+#[cfg(feature = "alloc")]
+mod ordinal {
+    use crate::{
+        cst::{Ci, year},
+        ordinal::{NuclideOrdinals, SolutionIndex},
+    };
+
+    use super::*;
+
+    #[test]
+    fn roundtrip() {
+        database!(db);
+        let ordinals = NuclideOrdinals::new(db);
+        assert_eq!(ordinals.len(), db.nuclides().len());
+        for (ordinal, nuclide) in db.nuclides().iter().enumerate() {
+            assert_eq!(ordinals.ordinal(nuclide), Some(ordinal));
+            assert!(core::ptr::eq(ordinals.nuclide(ordinal).unwrap(), *nuclide));
+        }
+        assert!(ordinals.nuclide(ordinals.len()).is_none());
+    }
+
+    #[test]
+    fn solution_index() {
+        database!(db);
+        let ordinals = NuclideOrdinals::new(db);
+        let u238 = db.nuclide(nuclide!(U - 238));
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(u238, 1.0 * Ci);
+        let index = SolutionIndex::new(&ordinals, &mx);
+        for (expected, nuclide) in mx.solution_nuclides().enumerate() {
+            assert_eq!(index.get(nuclide), Some(expected));
+        }
+        assert_eq!(index.get(co60), None);
+
+        #[cfg(feature = "std")]
+        {
+            use approx::assert_relative_eq;
+
+            let position = index.get(u238).unwrap();
+            let activity = mx.activity_by_solution_index(year, position).unwrap();
+            assert_relative_eq!(
+                activity,
+                mx.nuclide_activity(year, u238).unwrap(),
+                max_relative = 1e-9
+            );
+            assert!(mx.activity_by_solution_index(year, usize::MAX).is_none());
+        }
+    }
+}
+
+#[cfg(feature = "std")]
+mod solved {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{Ci, day, year},
+        ordinal::NuclideOrdinals,
+        solved::{DecodeError, SolvedMixture},
+    };
+
+    use super::*;
+
+    const _: () = {
+        const fn assert_send_sync<T: Send + Sync>() {}
+        assert_send_sync::<SolvedMixture<'static>>();
+    };
+
+    #[test]
+    fn matches_mixture() {
+        database!(db);
+        let u238 = db.nuclide(nuclide!(U - 238));
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(u238, 1.0 * Ci);
+        mx.add_nuclide_by_activity(co60, 2.0 * Ci);
+        let solved = mx.solve();
+        assert_eq!(solved.len(), mx.num_solution_nuclides());
+        assert_eq!(solved.initial_nuclides().len(), 2);
+        for time in [0.0, day, 10.0 * year] {
+            assert_relative_eq!(
+                solved.total_activity(time),
+                mx.total_activity(time),
+                max_relative = 1e-9
+            );
+            for nuclide in [u238, co60] {
+                assert_relative_eq!(
+                    solved.activity(time, nuclide).unwrap(),
+                    mx.nuclide_activity(time, nuclide).unwrap(),
+                    max_relative = 1e-9
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn stress_64_threads() {
+        database!(db);
+        let ra226 = db.nuclide(nuclide!(Ra - 226));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(ra226, 1.0 * Ci);
+        let solved = std::sync::Arc::new(mx.solve());
+        let times = (0..256).map(|i| f64::from(i) * day).collect::<Vec<_>>();
+        let expected = times
+            .iter()
+            .map(|&time| solved.total_activity(time))
+            .collect::<Vec<_>>();
+        std::thread::scope(|scope| {
+            for thread in 0..64 {
+                let solved = std::sync::Arc::clone(&solved);
+                let (times, expected) = (&times, &expected);
+                scope.spawn(move || {
+                    let mut activities = vec![0.0; solved.len()];
+                    for round in 0..50 {
+                        let i = (thread * 7 + round * 13) % times.len();
+                        assert_eq!(solved.total_activity(times[i]), expected[i]);
+                        solved.activities_into(times[i], &mut activities);
+                        assert!(activities.iter().all(|a| a.is_finite()));
+                        assert!(solved.activity(times[i], ra226).unwrap() > 0.0);
+                    }
+                });
+            }
+        });
+    }
+
+    #[test]
+    fn bytes_roundtrip() {
+        database!(db);
+        let ordinals = NuclideOrdinals::new(db);
+        let u238 = db.nuclide(nuclide!(U - 238));
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(u238, 1.0 * Ci);
+        mx.add_nuclide_by_activity(co60, 2.0 * Ci);
+        let solved = mx.solve();
+        let bytes = solved.to_bytes(&ordinals);
+        assert_eq!(bytes.len(), solved.serialized_len());
+        let loaded = SolvedMixture::from_bytes(&bytes, &ordinals).unwrap();
+        assert_eq!(loaded.len(), solved.len());
+        assert_eq!(loaded.initial_nuclides().len(), 2);
+        for time in [0.0, day, 10.0 * year] {
+            assert_eq!(loaded.total_activity(time), solved.total_activity(time));
+            assert_eq!(
+                loaded.activity(time, co60).unwrap(),
+                solved.activity(time, co60).unwrap()
+            );
+        }
+
+        assert_eq!(
+            SolvedMixture::from_bytes(&bytes[..bytes.len() - 1], &ordinals).unwrap_err(),
+            DecodeError::Malformed
+        );
+        let mut foreign = bytes.clone();
+        foreign[6] ^= 1;
+        assert!(matches!(
+            SolvedMixture::from_bytes(&foreign, &ordinals),
+            Err(DecodeError::FingerprintMismatch { .. })
+        ));
+        assert_eq!(
+            SolvedMixture::from_bytes(b"nope", &ordinals).unwrap_err(),
+            DecodeError::BadMagic
+        );
+    }
+
+    #[test]
+    fn pruned_within_bound() {
+        database!(db);
+        let ra226 = db.nuclide(nuclide!(Ra - 226));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(ra226, 1.0 * Ci);
+        let solved = mx.solve();
+        let (pruned, report) = solved.pruned(year, 100.0 * year, 1e-6);
+        assert_eq!(report.terms_before, solved.num_terms());
+        assert_eq!(report.terms_after, pruned.num_terms());
+        assert!(report.terms_after < report.terms_before);
+        assert!(report.max_relative_error <= 1e-6);
+        for i in 0..=100 {
+            let time = year + f64::from(i) * 0.99 * year;
+            let error = (pruned.total_activity(time) - solved.total_activity(time)).abs();
+            assert!(error <= report.total_activity_error * (1.0 + 1e-9) + 1e-9);
+        }
+        let (exact, report) = solved.pruned(year, 100.0 * year, 0.0);
+        assert_eq!(report.max_relative_error, 0.0);
+        assert_eq!(exact.total_activity(year), solved.total_activity(year));
+    }
+}
+
+#[cfg(feature = "std")]
+mod inventory {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{Ci, day, year},
+        inventory::{ChainCache, Inventory},
+    };
+
+    use super::*;
+
+    #[test]
+    fn variants_share_chains() {
+        database!(db);
+        let u238 = db.nuclide(nuclide!(U - 238));
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let cs137 = db.nuclide(nuclide!(Cs - 137));
+        let cache = ChainCache::new();
+        let mut base = Inventory::new();
+        base.add_nuclide_by_activity(u238, 1.0 * Ci, &cache);
+        base.add_nuclide_by_activity(co60, 1.0 * Ci, &cache);
+        assert_eq!(cache.len(), 2);
+
+        let mut variant = base.clone();
+        assert!(variant.shares_parents_with(&base));
+        variant.add_nuclide_by_activity(cs137, 1.0 * Ci, &cache);
+        assert!(!variant.shares_parents_with(&base));
+        assert_eq!(cache.len(), 3);
+        assert_eq!((base.len(), variant.len()), (2, 3));
+        assert!(variant.remove_nuclide(co60).is_some());
+        assert!(variant.remove_nuclide(co60).is_none());
+
+        // reference: same nuclides in a regular mixture
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(u238, 1.0 * Ci);
+        mx.add_nuclide_by_activity(cs137, 1.0 * Ci);
+        let solved = variant.solve();
+        for time in [0.0, day, 30.0 * year] {
+            assert_relative_eq!(
+                variant.total_activity(time),
+                mx.total_activity(time),
+                max_relative = 1e-9
+            );
+            assert_relative_eq!(
+                solved.total_activity(time),
+                mx.total_activity(time),
+                max_relative = 1e-9
+            );
+            assert_relative_eq!(
+                variant.activity(time, cs137),
+                mx.nuclide_activity(time, cs137).unwrap(),
+                max_relative = 1e-9
+            );
+        }
+        assert_eq!(solved.initial_nuclides().len(), 2);
+
+        let from_mixture = Inventory::from_mixture(&mx, &cache);
+        assert_eq!(cache.len(), 3);
+        assert_relative_eq!(
+            from_mixture.total_activity(year),
+            mx.total_activity(year),
+            max_relative = 1e-9
+        );
+    }
+
+    #[test]
+    fn parallel_deterministic() {
+        database!(db);
+        let parents = [
+            nuclide!(U - 238),
+            nuclide!(Th - 232),
+            nuclide!(Co - 60),
+            nuclide!(Cs - 137),
+            nuclide!(Eu - 152),
+        ]
+        .map(|spec| (db.nuclide(spec), 1e20));
+        let cache = ChainCache::new();
+        let parallel = Inventory::from_nuclides_parallel(&parents, &cache, 4);
+        assert_eq!(cache.len(), parents.len());
+        let mut sequential = Inventory::new();
+        for &(nuclide, atoms) in &parents {
+            sequential.add_nuclide_by_atoms(nuclide, atoms, &cache);
+        }
+        let solved = parallel.solve();
+        assert_eq!(
+            solved.total_activity(year),
+            sequential.solve().total_activity(year)
+        );
+
+        let lines = crate::lines::LineIndex::photons(db);
+        let single = solved.line_rates_parallel(&lines, year, 1);
+        assert_eq!(single, solved.line_rates_parallel(&lines, year, 7));
+        assert!(single.windows(2).all(|pair| pair[0].0 < pair[1].0));
+        let total = single.iter().map(|(_, rate)| rate).sum::<f64>();
+        let expected = solved
+            .nuclides()
+            .iter()
+            .enumerate()
+            .filter_map(|(index, nuclide)| {
+                let nuclide_lines = lines.lines(nuclide)?;
+                Some(
+                    solved.activity_at(year, index) * nuclide_lines.intensities.iter().sum::<f64>(),
+                )
+            })
+            .sum::<f64>();
+        assert_relative_eq!(total, expected, max_relative = 1e-9);
+        assert_eq!(
+            solved.line_counts_parallel(&lines, 0.0, day, 2),
+            solved.line_counts_parallel(&lines, 0.0, day, 5)
+        );
+
+        let mut decays = vec![0.0; solved.len()];
+        solved.num_decays_into(0.0, day, &mut decays);
+        let mut decays_parallel = vec![0.0; solved.len()];
+        solved.num_decays_parallel(0.0, day, &mut decays_parallel, 3);
+        assert_eq!(decays, decays_parallel);
+    }
+}
+
+#[cfg(feature = "std")]
+mod lazy {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{Ci, day, year},
+        lazy::LazyMixture,
+    };
+
+    use super::*;
+
+    #[test]
+    fn matches_mixture() {
+        database!(db);
+        let ra226 = db.nuclide(nuclide!(Ra - 226));
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let pb214 = db.nuclide(nuclide!(Pb - 214));
+        let pb210 = db.nuclide(nuclide!(Pb - 210));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(ra226, 1.0 * Ci);
+        mx.add_nuclide_by_activity(co60, 2.0 * Ci);
+        let mut lazy = LazyMixture::new();
+        lazy.add_nuclide_by_activity(ra226, 1.0 * Ci);
+        lazy.add_nuclide_by_activity(co60, 2.0 * Ci);
+        assert_eq!(lazy.num_solved(), 0);
+        for time in [day, 30.0 * day, 10.0 * year] {
+            for nuclide in [ra226, co60, pb214, pb210] {
+                assert_relative_eq!(
+                    lazy.activity(time, nuclide),
+                    mx.nuclide_activity(time, nuclide).unwrap(),
+                    max_relative = 1e-6
+                );
+            }
+        }
+        assert_eq!(lazy.num_solved(), 4);
+        assert_eq!(lazy.activity(year, db.nuclide(nuclide!(U - 238))), 0.0);
+
+        let subset = lazy.solve_subset(&[pb210, ra226, pb210]);
+        assert_eq!(subset.len(), 2);
+        assert_eq!(subset.initial_nuclides().len(), 1);
+        assert_relative_eq!(
+            subset.total_activity(year),
+            mx.nuclide_activity(year, pb210).unwrap() + mx.nuclide_activity(year, ra226).unwrap(),
+            max_relative = 1e-6
+        );
+    }
+}
+
+#[cfg(feature = "std")]
+mod equilibrium {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{Ci, day, year},
+        equilibrium::EquilibriumFolding,
+    };
+
+    use super::*;
+
+    #[test]
+    fn ra226_folded() {
+        database!(db);
+        let ra226 = db.nuclide(nuclide!(Ra - 226));
+        let rn222 = db.nuclide(nuclide!(Rn - 222));
+        let pb214 = db.nuclide(nuclide!(Pb - 214));
+        let bi214 = db.nuclide(nuclide!(Bi - 214));
+        let pb210 = db.nuclide(nuclide!(Pb - 210));
+        let po210 = db.nuclide(nuclide!(Po - 210));
+        let mut tmp = MaybeUninit::uninit();
+        let mut mx = crate::LocalMixture::new_in(&mut tmp);
+        mx.add_nuclide_by_activity(ra226, 1.0 * Ci);
+        let atoms = 1.0 * Ci / ra226.decay_constant();
+        let folded = EquilibriumFolding::new(30.0 * day).solve(&[(ra226, atoms)]);
+        assert!(folded.folded().index(pb214).is_some());
+        assert!(folded.kept().index(rn222).is_some());
+        assert!(folded.num_terms() < mx.solve().num_terms());
+        for time in [30.0 * day, year, 10.0 * year] {
+            for nuclide in [ra226, rn222, pb214, bi214, pb210, po210] {
+                assert_relative_eq!(
+                    folded.activity(time, nuclide).unwrap(),
+                    mx.nuclide_activity(time, nuclide).unwrap(),
+                    max_relative = 1e-6
+                );
+            }
+            assert_relative_eq!(
+                folded.total_activity(time),
+                mx.total_activity(time),
+                max_relative = 1e-6
+            );
+        }
+    }
+}
+
+#[cfg(feature = "std")]
+mod batch {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        batch::{MixtureBatch, SharedExponentials},
+        cst::{Ci, day, year},
+    };
+
+    use super::*;
+
+    #[test]
+    fn matches_solved() {
+        database!(db);
+        let ra226 = db.nuclide(nuclide!(Ra - 226));
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let cs137 = db.nuclide(nuclide!(Cs - 137));
+        let solved = (1..=8)
+            .map(|i| {
+                let mut mx = crate::Mixture::new();
+                mx.add_nuclide_by_activity(ra226, f64::from(i) * Ci);
+                mx.add_nuclide_by_activity(if i % 2 == 0 { co60 } else { cs137 }, Ci);
+                mx.solve()
+            })
+            .collect::<Vec<_>>();
+        let batch = SharedExponentials::new(&solved);
+        assert_eq!(batch.len(), solved.len());
+        assert!(batch.exponents().len() < solved.iter().map(|s| s.num_terms()).sum());
+        let layout = MixtureBatch::new(&solved);
+        assert_eq!(layout.len(), solved.len());
+
+        let times = [0.0, day, year];
+        let mut totals = vec![0.0; batch.len() * times.len()];
+        batch.total_activities_into(&times, &mut totals);
+        let mut activities = vec![0.0; batch.num_activities()];
+        batch.activities_into(year, &mut activities);
+        let mut layout_totals = vec![0.0; layout.len()];
+        layout.total_activities_parallel(year, &mut layout_totals, 3);
+        let mut rows = vec![0.0; layout.nuclides().len() * layout.len()];
+        layout.activities_parallel(year, &mut rows, 4);
+        for (m, mixture) in solved.iter().enumerate() {
+            for (t, &time) in times.iter().enumerate() {
+                assert_relative_eq!(
+                    totals[m * times.len() + t],
+                    mixture.total_activity(time),
+                    max_relative = 1e-9
+                );
+            }
+            assert_relative_eq!(
+                layout_totals[m],
+                mixture.total_activity(year),
+                max_relative = 1e-9
+            );
+            for (row, nuclide) in layout.nuclides().iter().enumerate() {
+                let expected = mixture.activity(year, nuclide).unwrap_or(0.0);
+                assert_relative_eq!(rows[row * layout.len() + m], expected, max_relative = 1e-9);
+            }
+            let range = batch.activity_range(m);
+            assert_eq!(range.len(), mixture.len());
+            for (index, activity) in activities[range].iter().enumerate() {
+                assert_relative_eq!(
+                    *activity,
+                    mixture.activity_at(year, index),
+                    max_relative = 1e-9
+                );
+            }
+        }
+    }
+}
+
+#[cfg(feature = "std")]
+mod reload {
+    use crate::reload::ReloadableDatabase;
+
+    use super::*;
+
+    #[test]
+    fn swap_under_readers() {
+        let database = std::sync::Arc::new(ReloadableDatabase::new(
+            SharedDatabase::from_bytes(DATABASE_BYTES).expect("should init database"),
+        ));
+        let mut reader = database.reader();
+        let old = reader.get().clone();
+        let co60 = old.nuclide(nuclide!(Co - 60));
+        std::thread::scope(|scope| {
+            for _ in 0..4 {
+                let database = &database;
+                scope.spawn(move || {
+                    let mut reader = database.reader();
+                    for _ in 0..1000 {
+                        let half_life = reader.get().nuclide(nuclide!(Co - 60)).half_life;
+                        assert_eq!(half_life, co60.half_life);
+                    }
+                });
+            }
+            assert_eq!(database.reload_bytes(DATABASE_BYTES).unwrap(), 1);
+        });
+        assert!(reader.is_stale());
+        // old snapshot is still alive
+        assert!(core::ptr::eq(
+            reader.snapshot().nuclide(nuclide!(Co - 60)),
+            co60
+        ));
+        let new = reader.get().nuclide(nuclide!(Co - 60));
+        assert!(!core::ptr::eq(new, co60));
+        assert_eq!(new.half_life, co60.half_life);
+        // reader has not dropped it's old snapshot, but retired it
+        assert!(database.reclaim() >= 1);
+        assert_eq!(database.reclaim(), 0);
+        assert_eq!(
+            database
+                .reload_in_background(DATABASE_FILENAME)
+                .join()
+                .unwrap()
+                .unwrap(),
+            2
+        );
+        assert!(
+            database
+                .reload_path(c"bad_non_existing_database.idk")
+                .is_err()
+        );
+        assert_eq!(database.generation(), 2);
+    }
+}
+
+#[cfg(feature = "std")]
+mod overlay {
+    use approx::assert_relative_eq;
+
+    use crate::{
+        cst::{keV, second},
+        inventory::{ChainCache, Inventory},
+        lines::{LineIndex, LineSelection},
+        overlay::{Overlay, OverlayError},
+    };
+
+    use super::*;
+
+    #[test]
+    fn degenerate_patch_rejected() {
+        database!(db);
+        let cs137 = db.nuclide(nuclide!(Cs - 137));
+        let ba137m = db.nuclide("Ba137m");
+        let mut overlay = Overlay::new();
+        overlay.set_half_life(cs137, ba137m.half_life);
+        assert!(overlay.solve(&[(cs137, 1.0)]).is_none());
+
+        let cache = ChainCache::new();
+        let chain = cache.get(cs137);
+        assert!(matches!(
+            cache.apply_overlay(&overlay),
+            Err(OverlayError::DegenerateChain(_))
+        ));
+        // overlay is not applied
+        assert!(alloc::sync::Arc::ptr_eq(&cache.get(cs137), &chain));
+
+        let cache = ChainCache::new();
+        assert_eq!(cache.apply_overlay(&overlay).unwrap(), 0);
+        assert!(cache.try_get(cs137).is_none());
+        assert!(cache.is_empty());
+
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        assert!(matches!(
+            Inventory::try_from_nuclides_parallel(&[(co60, 1.0), (cs137, 1.0)], &cache, 2),
+            Err(OverlayError::DegenerateChain(symbol)) if symbol == "Cs137"
+        ));
+        let mut inventory = Inventory::new();
+        inventory.add_nuclide_by_atoms(co60, 1.0, &cache);
+        assert!(
+            inventory
+                .try_add_nuclide_by_atoms(cs137, 1.0, &cache)
+                .is_err()
+        );
+        assert_eq!(inventory.len(), 1);
+    }
+
+    #[test]
+    fn patch_affects_only_corrected() {
+        database!(db);
+        let co60 = db.nuclide(nuclide!(Co - 60));
+        let cs137 = db.nuclide(nuclide!(Cs - 137));
+        let cache = ChainCache::new();
+        let original = cache
+            .get(co60)
+            .solved()
+            .activity(co60.half_life, co60)
+            .unwrap();
+        let cs137_chain = cache.get(cs137);
+
+        let half_life = 2.0 * co60.half_life / second;
+        let patch = format!(
+            r#"<?xml version="1.0"?>
+            <patch>
+              <!-- corrected -->
+              <nuclide symbol="Co60" halfLife="{half_life}"/>
+              <gamma nuclide="Cs137" energy="1000.5" intensity="0.25"/>
+            </patch>"#
+        );
+        let overlay = Overlay::parse(db, &patch).unwrap();
+        assert_relative_eq!(overlay.half_life(co60), 2.0 * co60.half_life);
+        assert_eq!(overlay.half_life(cs137), cs137.half_life);
+        assert!(overlay.affects_chain(co60));
+        assert!(!overlay.affects_chain(cs137));
+
+        // activity after old half-life: 2^(-1/2) instead of 2^(-1) of initial one
+        let solved = overlay.solve(&[(co60, 1.0)]).unwrap();
+        let initial = solved.activity(0.0, co60).unwrap();
+        assert_relative_eq!(
+            solved.activity(co60.half_life, co60).unwrap(),
+            initial * 0.5f64.sqrt(),
+            max_relative = 1e-12
+        );
+
+        assert_eq!(cache.apply_overlay(&overlay).unwrap(), 1);
+        assert!(alloc::sync::Arc::ptr_eq(&cache.get(cs137), &cs137_chain));
+        let corrected = cache
+            .get(co60)
+            .solved()
+            .activity(co60.half_life, co60)
+            .unwrap();
+        assert_relative_eq!(corrected, original * 0.5f64.sqrt(), max_relative = 1e-9);
+
+        let index = LineIndex::from_nuclides([co60, cs137], LineSelection::PHOTONS);
+        let patched = index.patched(&overlay, LineSelection::PHOTONS);
+        assert_eq!(patched.num_lines(), index.num_lines() + 1);
+        assert_eq!(
+            patched.lines(co60).unwrap().energies,
+            index.lines(co60).unwrap().energies
+        );
+        let lines = patched.lines(cs137).unwrap();
+        let position = lines
+            .energies
+            .iter()
+            .position(|&energy| energy == 1000.5 * keV)
+            .unwrap();
+        assert_eq!(lines.intensities[position], 0.25);
+
+        assert!(matches!(
+            Overlay::parse(db, r#"<nuclide symbol="Xx999" halfLife="1"/>"#),
+            Err(OverlayError::UnknownNuclide(_))
+        ));
+        assert!(matches!(
+            Overlay::parse(db, r#"<gamma nuclide="Co60" energy="x" intensity="1"/>"#),
+            Err(OverlayError::BadNumber { .. })
+        ));
+        assert!(matches!(
+            Overlay::parse(db, "<nuclide symbol=\"Co60\""),
+            Err(OverlayError::Syntax(0))
+        ));
+    }
+}
+
+#[cfg(feature = "std")]
+mod compression {
+    use std::io::{self, Write};
+
+    use crate::compression::{
+        CompressedInitError, CompressedLoader, Compression, gzip_size, zstd_content_size,
+    };
+
+    use super::*;
+
+    fn gzip(data: &[u8]) -> Vec<u8> {
+        let mut encoder = flate2::write::GzEncoder::new(Vec::new(), flate2::Compression::fast());
+        encoder.write_all(data).unwrap();
+        encoder.finish().unwrap()
+    }
+
+    fn loader() -> CompressedLoader {
+        CompressedLoader::empty()
+            .with_gzip(|input, out| {
+                io::copy(&mut flate2::read::MultiGzDecoder::new(input), out).map(drop)
+            })
+            .with_zstd(|input, out| zstd::stream::copy_decode(input, out))
+    }
+
+    #[test]
+    fn detect_and_stream() {
+        assert_eq!(Compression::detect(DATABASE_BYTES), Compression::None);
+        assert_eq!(Compression::detect(b"\x1f\x8b\x08"), Compression::Gzip);
+        assert_eq!(
+            Compression::detect(b"\x28\xb5\x2f\xfd\x00"),
+            Compression::Zstd
+        );
+
+        // uncompressed data is not copied
+        let loader = CompressedLoader::empty();
+        assert!(matches!(
+            loader.decompress_bytes(DATABASE_BYTES).unwrap(),
+            std::borrow::Cow::Borrowed(_)
+        ));
+        assert!(!loader.supports(Compression::Gzip));
+        assert!(matches!(
+            loader.decompress_bytes(b"\x1f\x8b\x08"),
+            Err(CompressedInitError::NoDecoder(Compression::Gzip))
+        ));
+        assert_eq!(
+            CompressedLoader::new().supports(Compression::Gzip),
+            cfg!(feature = "gzip")
+        );
+        assert_eq!(
+            CompressedLoader::new().supports(Compression::Zstd),
+            cfg!(feature = "zstd")
+        );
+
+        // "decoder" stripping the magic, to check the plumbing
+        let loader = loader.with_zstd(|input, out| {
+            let mut magic = [0; 4];
+            input.read_exact(&mut magic)?;
+            io::copy(input, out).map(drop)
+        });
+        let mut compressed = Compression::ZSTD_MAGIC.to_vec();
+        compressed.extend_from_slice(DATABASE_BYTES);
+        let decompressed = loader.decompress_bytes(&compressed).unwrap();
+        assert_eq!(&decompressed[..DATABASE_BYTES.len()], DATABASE_BYTES);
+        assert_eq!(decompressed.last(), Some(&0));
+        assert_eq!(
+            loader.decompress_reader(compressed.as_slice()).unwrap(),
+            decompressed.as_ref()
+        );
+        let database: SharedDatabase = loader.load_bytes(&compressed).unwrap();
+        let _ = database.nuclide(nuclide!(Co - 60));
+        assert!(matches!(
+            loader.load_path::<crate::container::ArcContainer<_>>("bad_non_existing_database.idk"),
+            Err(CompressedInitError::Io(_))
+        ));
+    }
+
+    #[test]
+    fn round_trip() {
+        database!(db);
+        let nuclides = db.nuclides().len();
+        let loader = loader();
+        let gzipped = gzip(DATABASE_BYTES);
+        let zstded = zstd::bulk::compress(DATABASE_BYTES, 3).unwrap();
+        assert_eq!(gzip_size(&gzipped), Some(DATABASE_BYTES.len()));
+        assert_eq!(zstd_content_size(&zstded), Some(DATABASE_BYTES.len()));
+
+        let directory = std::env::temp_dir();
+        for (compressed, extension) in [(gzipped, "gz"), (zstded, "zst")] {
+            let decompressed = loader.decompress_bytes(&compressed).unwrap();
+            assert_eq!(&decompressed[..DATABASE_BYTES.len()], DATABASE_BYTES);
+            assert_eq!(&decompressed[DATABASE_BYTES.len()..], [0]);
+
+            let database: SharedDatabase = loader.load_bytes(&compressed).unwrap();
+            assert_eq!(database.nuclides().len(), nuclides);
+
+            let path = directory.join(format!(
+                "sdecay-round-trip-{}.xml.{extension}",
+                std::process::id()
+            ));
+            std::fs::write(&path, &compressed).unwrap();
+            let decompressed = loader.decompress_path(&path);
+            let database = loader.load_path::<crate::container::ArcContainer<_>>(&path);
+            std::fs::remove_file(&path).unwrap();
+            assert_eq!(
+                &decompressed.unwrap()[..DATABASE_BYTES.len()],
+                DATABASE_BYTES
+            );
+            assert_eq!(database.unwrap().nuclides().len(), nuclides);
+        }
+
+        // concatenated gzip members decode as a whole
+        let split = DATABASE_BYTES.len() / 2;
+        let mut members = gzip(&DATABASE_BYTES[..split]);
+        members.extend(gzip(&DATABASE_BYTES[split..]));
+        let database: SharedDatabase = loader.load_bytes(&members).unwrap();
+        assert_eq!(database.nuclides().len(), nuclides);
+    }
+
+    #[test]
+    fn stored_sizes() {
+        // gzip stores size modulo 2^32 in the last 4 bytes
+        assert_eq!(gzip_size(&gzip(b"")), Some(0));
+        assert_eq!(gzip_size(&gzip(&[b'a'; 1000])), Some(1000));
+        assert_eq!(
+            gzip_size(&[0x1f, 0x8b, 0x78, 0x56, 0x34, 0x12]),
+            Some(0x1234_5678)
+        );
+        assert_eq!(gzip_size(&[0x1f, 0x8b, 0x00]), None);
+
+        let frame = |descriptor: u8, rest: &[u8]| {
+            let mut frame = Compression::ZSTD_MAGIC.to_vec();
+            frame.push(descriptor);
+            frame.extend_from_slice(rest);
+            frame
+        };
+        // 1-byte field, only in single-segment frames
+        assert_eq!(zstd_content_size(&frame(0x20, &[200])), Some(200));
+        assert_eq!(zstd_content_size(&frame(0x00, &[0x58, 200])), None);
+        // 2-byte field is offset by 256; window descriptor precedes it
+        assert_eq!(
+            zstd_content_size(&frame(0x40, &[0x58, 0x34, 0x12])),
+            Some(0x1234 + 256)
+        );
+        // 4-byte field after 1-byte dictionary id
+        assert_eq!(
+            zstd_content_size(&frame(0xa1, &[7, 0x78, 0x56, 0x34, 0x12])),
+            Some(0x1234_5678)
+        );
+        // 8-byte field after window descriptor and 4-byte dictionary id
+        assert_eq!(
+            zstd_content_size(&frame(
+                0xc3,
+                &[
+                    0x58, 1, 2, 3, 4, 0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01
+                ]
+            )),
+            usize::try_from(0x0123_4567_89ab_cdef_u64).ok()
+        );
+        // truncated field
+        assert_eq!(zstd_content_size(&frame(0x80, &[0x58, 1, 2])), None);
+        assert_eq!(zstd_content_size(&Compression::ZSTD_MAGIC), None);
+
+        // sizes written by the encoder, picking the shortest field
+        for size in [0, 200, 1000, 100_000] {
+            let data = vec![b'a'; size];
+            let compressed = zstd::bulk::compress(&data, 1).unwrap();
+            assert_eq!(zstd_content_size(&compressed), Some(size));
+        }
+    }
+}
+
+mod scan {
+    use crate::scan::{ScanError, nuclide_headers};
+
+    use super::*;
+
+    #[test]
+    fn headers_bit_identical() {
+        database!(db);
+        let xml = core::str::from_utf8(DATABASE_BYTES).expect("database should be utf-8");
+        let mut count = 0;
+        for header in nuclide_headers(xml) {
+            let header = header.expect("database should be well-formed");
+            let nuclide = db
+                .nuclide_by_name(header.symbol)
+                .expect("scanned nuclide should be in the database");
+            assert_eq!(header.atomic_number, nuclide.atomic_number);
+            assert_eq!(header.mass_number, nuclide.mass_number);
+            assert_eq!(header.isomer_number, nuclide.isomer_number);
+            assert_eq!(header.atomic_mass.to_bits(), nuclide.atomic_mass.to_bits());
+            if header.half_life.is_finite() {
+                assert_eq!(header.half_life.to_bits(), nuclide.half_life.to_bits());
+            }
+            count += 1;
+        }
+        assert_eq!(count, db.nuclides().len());
+
+        let mut headers =
+            nuclide_headers(r#"<nuclide symbol="Co60" atomicNumber="27"/><nuclide symbol="#);
+        assert!(matches!(
+            headers.next(),
+            Some(Err(ScanError::MissingAttribute {
+                offset: 0,
+                attribute: "massNumber"
+            }))
+        ));
+        assert_eq!(headers.next(), Some(Err(ScanError::Syntax(42))));
+        assert_eq!(headers.next(), None);
+    }
+
+    #[test]
+    fn number_syntax() {
+        use crate::xml::{parse_f32, parse_f64};
+
+        assert_eq!(parse_f64(" 2.5e3 "), Some(2500.0));
+        assert_eq!(parse_f64("-1E-2"), Some(-0.01));
+        assert_eq!(parse_f64("inf"), Some(f64::INFINITY));
+        assert!(parse_f64("nan").unwrap().is_nan());
+        // `strtod` reads these partially or as hexadecimal
+        assert_eq!(parse_f64("1.5s"), None);
+        assert_eq!(parse_f64("0x1p3"), None);
+        assert_eq!(parse_f64(""), None);
+        // narrowed from `f64`, not parsed directly: just above `f32` halfway, but `f64` rounds to it exactly, and then ties to even
+        let halfway = "1.000000059604644775390625001";
+        assert_eq!(parse_f32(halfway), Some(1.0));
+        assert_ne!(halfway.parse::<f32>(), Ok(1.0));
+
+        let header = r#"<nuclide symbol="Co60" atomicNumber="27" massNumber="60" isomerNumber="0" atomicMass="59.93" halfLife="1.5s"/>"#;
+        assert_eq!(
+            nuclide_headers(header).next(),
+            Some(Err(ScanError::BadNumber {
+                offset: 0,
+                attribute: "halfLife"
+            }))
+        );
+    }
+}
+
+#[cfg(feature = "std")]
+mod lazy_database {
+    use crate::{
+        lazy_database::LazyDatabase,
+        wrapper::{CoincidencePair, DecayModeD, ProductTypeD},
+    };
+
+    use super::*;
+
+    #[test]
+    fn modes_and_coincidences() {
+        let lazy = LazyDatabase::from_xml(
+            r#"<document>
+              <nuclide symbol="Ni60" atomicNumber="28" massNumber="60" isomerNumber="0" atomicMass="59.93" halfLife="inf"/>
+              <nuclide symbol="Co60" atomicNumber="27" massNumber="60" isomerNumber="0" atomicMass="59.93" halfLife="1.66e8">
+                <transition child="Ni60" mode="b-" branchRatio="1.0">
+                  <gamma energy="1173.2" intensity="0.99"><coincidence index="1" fraction="0.99"/></gamma>
+                  <unknown energy="1.0" intensity="1.0"><coincidence index="0" fraction="1.0"/></unknown>
+                  <gamma energy="1332.5" intensity="0.99"><coincidence index="0" fraction="0.98"/></gamma>
+                </transition>
+                <transition child="Ni60" mode="weird" branchRatio="0.0"/>
+              </nuclide>
+            </document>"#
+                .to_owned(),
+        )
+        .unwrap();
+        let co60 = lazy.nuclide("Co60").unwrap();
+        let mut transitions = co60.transitions();
+        let transition = transitions.next().unwrap();
+        assert_eq!(transition.mode().d(), DecayModeD::BetaDecay);
+        let particles = transition.particles().unwrap();
+        assert_eq!(particles.len(), 2);
+        assert_eq!(*particles[0].coincidences, [CoincidencePair(1, 0.99)]);
+        // coincidence of unknown element is not attached to a neighbour
+        assert_eq!(*particles[1].coincidences, [CoincidencePair(0, 0.98)]);
+        let transition = transitions.next().unwrap();
+        assert_eq!(transition.mode().d(), DecayModeD::UndefinedDecay);
+        assert!(transition.particles().unwrap().is_empty());
+    }
+
+    #[test]
+    fn matches_database() {
+        database!(db);
+        let lazy = LazyDatabase::from_bytes(DATABASE_BYTES.to_vec()).unwrap();
+        assert_eq!(lazy.len(), db.nuclides().len());
+        for nuclide in lazy.nuclides() {
+            let reference = db.nuclide_by_name(nuclide.symbol()).unwrap();
+            assert_eq!(nuclide.half_life().to_bits(), reference.half_life.to_bits());
+            assert_eq!(nuclide.decay_constant(), reference.decay_constant());
+            assert_eq!(
+                nuclide.transitions().len(),
+                reference.decays_to_children.len()
+            );
+        }
+        assert_eq!(lazy.num_materialized(), 0);
+
+        let co60 = lazy.nuclide("Co60").unwrap();
+        let transition = co60.transitions().next().unwrap();
+        assert_eq!(transition.child().unwrap().symbol(), "Ni60");
+        let particles = std::thread::scope(|scope| {
+            let threads = (0..4)
+                .map(|_| scope.spawn(|| transition.particles().unwrap()))
+                .collect::<Vec<_>>();
+            threads
+                .into_iter()
+                .map(|thread| thread.join().unwrap())
+                .collect::<Vec<_>>()
+        });
+        // parsed once
+        assert!(particles.iter().all(|p| core::ptr::eq(*p, particles[0])));
+        assert_eq!(lazy.num_materialized(), 1);
+
+        let reference = db.nuclide(nuclide!(Co - 60));
+        let reference = reference
+            .decays_to_children
+            .iter()
+            .find(|transition| transition.child.is_some_and(|child| child.symbol == "Ni60"))
+            .unwrap();
+        let mut energies = particles[0]
+            .iter()
+            .filter(|particle| particle.r#type.d() == ProductTypeD::GammaParticle)
+            .map(|particle| particle.energy.to_bits())
+            .collect::<Vec<_>>();
+        let mut expected = reference
+            .products
+            .iter()
+            .filter(|particle| particle.r#type.d() == ProductTypeD::GammaParticle)
+            .map(|particle| particle.energy.to_bits())
+            .collect::<Vec<_>>();
+        energies.sort_unstable();
+        expected.sort_unstable();
+        assert_eq!(energies, expected);
+    }
+
+    #[test]
+    fn transitions_bit_identical() {
+        database!(db);
+        let lazy = LazyDatabase::from_bytes(DATABASE_BYTES.to_vec()).unwrap();
+        for nuclide in lazy.nuclides() {
+            let reference = db.nuclide_by_name(nuclide.symbol()).unwrap();
+            // transitions are compared as multisets, by child, branch ratio and particles
+            let mut transitions = nuclide
+                .transitions()
+                .map(|transition| {
+                    let mut particles = transition
+                        .particles()
+                        .expect("database should be well-formed")
+                        .iter()
+                        .map(|p| {
+                            let coincidences = p
+                                .coincidences
+                                .iter()
+                                .map(|&CoincidencePair(index, fraction)| {
+                                    (index, fraction.to_bits())
+                                })
+                                .collect::<Vec<_>>();
+                            (
+                                p.r#type,
+                                p.energy.to_bits(),
+                                p.intensity.to_bits(),
+                                coincidences,
+                            )
+                        })
+                        .collect::<Vec<_>>();
+                    particles.sort_unstable();
+                    let child = transition.child().map(|child| child.symbol().to_owned());
+                    let mode = transition.mode();
+                    (child, mode, transition.branch_ratio().to_bits(), particles)
+                })
+                .collect::<Vec<_>>();
+            let mut expected = reference
+                .decays_to_children
+                .iter()
+                .map(|transition| {
+                    let mut particles = transition
+                        .products
+                        .iter()
+                        .map(|p| {
+                            let coincidences = p
+                                .coincidences
+                                .iter()
+                                .map(|&CoincidencePair(index, fraction)| {
+                                    (index, fraction.to_bits())
+                                })
+                                .collect::<Vec<_>>();
+                            (
+                                p.r#type,
+                                p.energy.to_bits(),
+                                p.intensity.to_bits(),
+                                coincidences,
+                            )
+                        })
+                        .collect::<Vec<_>>();
+                    particles.sort_unstable();
+                    let child = transition.child.map(|child| child.symbol.to_string());
+                    let mode = transition.mode;
+                    (child, mode, transition.branch_ratio.to_bits(), particles)
+                })
+                .collect::<Vec<_>>();
+            transitions.sort_unstable();
+            expected.sort_unstable();
+            assert_eq!(transitions, expected, "{}", nuclide.symbol());
+        }
+        assert_eq!(lazy.num_materialized(), lazy.num_transitions());
+    }
+}
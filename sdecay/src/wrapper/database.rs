@@ -133,14 +133,25 @@ impl SandiaDecayDataBase {
     ) -> Result<(), CppException> {
         let mut tmp = MaybeUninit::uninit();
         let mut bytes_vec = VecChar::from_bytes_in::<RefContainer<'_, _>>(&mut tmp, bytes);
+        self.init_vec(bytes_vec.inner())
+        // bytes vector will be dropped by `RefContainer`
+    }
+
+    /// Initializes the database from data already stored in C++ vector, with no copies
+    ///
+    /// Null terminator is pushed to the vector, unless it's present already. `SandiaDecay` parses data in place, so vector contents are unspecified afterwards
+    pub(crate) fn init_vec(
+        self: Pin<&mut Self>,
+        mut bytes: Pin<&mut VecChar>,
+    ) -> Result<(), CppException> {
         // `SandiaDecay` requires data vector to be null-terminated:
-        if bytes_vec.as_slice().last().is_none_or(|&b| b != 0) {
-            bytes_vec.inner().push(0);
+        if bytes.as_slice().last().is_none_or(|&b| b != 0) {
+            bytes.as_mut().push(0);
         }
         // SAFETY: obtained pointer is only used for database initialization; this operation does not move object out of it
         let self_ptr = unsafe { self.ptr_mut() };
         // SAFETY: (yes, Ivan, it had come to this) **I HOPE C++ SIDE WON'T DO STUPID THINGS**
-        let bytes_ptr = unsafe { bytes_vec.inner().bindgen_ptr_mut() };
+        let bytes_ptr = unsafe { bytes.bindgen_ptr_mut() };
         let mut ok = MaybeUninit::<sdecay_sys::sdecay::Unit>::uninit();
         let mut exception = MaybeUninit::<sdecay_sys::sdecay::Exception>::uninit();
         // SAFETY: ffi call with
@@ -155,7 +166,6 @@ impl SandiaDecayDataBase {
                 bytes_ptr.cast(),
             )
         };
-        // bytes vector will be dropped by `RefContainer`
         if tag {
             // call succeeded, assume database is init (`ffi::Unit` is trivially dropped)
             Ok(())
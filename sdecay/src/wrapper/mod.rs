@@ -101,10 +101,13 @@ pub use coincidence_pair::CoincidencePair;
 mod coincidence_pair {
     use core::ffi::c_ushort;
 
-    /// I have NO idea what this pair means
+    /// A particle coincident with the particle owning this pair
     ///
-    /// In case you happen to know, here it is -- easily accessible as Rust tuple
-    #[derive(Debug)]
+    /// - first element is an index of the coincident particle in parent [`Transition::products`](super::Transition::products)
+    /// - second element is a fraction of times coincident particle is emitted along with the owning one
+    ///
+    /// See [`crate::coincidence`] for an engine built on top of this data
+    #[derive(Debug, Clone, Copy, PartialEq)]
     #[repr(C)]
     pub struct CoincidencePair(pub c_ushort, pub f32);
 
@@ -280,3 +283,61 @@ wrapper! {
         pub evolutionTerms -> evolution_terms: time_evolution_term_vec => VecTimeEvolutionTerm,
     }
 }
+
+#[cfg(feature = "std")]
+impl TimeEvolutionTerm {
+    /// Evaluates the term at `time`
+    #[inline]
+    pub fn eval(&self, time: f64) -> f64 {
+        self.term_coeff * (-self.exponential_coeff * time).exp()
+    }
+
+    /// Integral of the term over $[t_0; t_1]$, computed in closed form
+    #[inline]
+    pub fn integral(&self, t0: f64, t1: f64) -> f64 {
+        term_integral(self.term_coeff, self.exponential_coeff, t0, t1)
+    }
+}
+
+/// Integral of $c \cdot \exp(-k t)$ over $[t_0; t_1]$
+#[cfg(feature = "std")]
+#[inline]
+pub(crate) fn term_integral(coeff: f64, exponent: f64, t0: f64, t1: f64) -> f64 {
+    if exponent == 0.0 {
+        coeff * (t1 - t0)
+    } else {
+        // expm1 keeps precision for short intervals
+        coeff * (-exponent * t0).exp() * -(-exponent * (t1 - t0)).exp_m1() / exponent
+    }
+}
+
+#[cfg(feature = "std")]
+impl NuclideTimeEvolution<'_> {
+    /// Number of atoms at `time`, i.e. sum of the [`TimeEvolutionTerm`]s
+    pub fn num_atoms(&self, time: f64) -> f64 {
+        self.evolution_terms
+            .as_slice()
+            .iter()
+            .map(|term| term.eval(time))
+            .sum()
+    }
+
+    /// Activity at `time`
+    #[inline]
+    pub fn activity(&self, time: f64) -> f64 {
+        self.num_atoms(time) * self.nuclide.decay_constant()
+    }
+
+    /// Number of decays in the time interval $[t_0; t_1]$
+    ///
+    /// Activity is integrated analytically, so result is exact for branching chains as well
+    pub fn num_decays(&self, t0: f64, t1: f64) -> f64 {
+        let atom_seconds: f64 = self
+            .evolution_terms
+            .as_slice()
+            .iter()
+            .map(|term| term.integral(t0, t1))
+            .sum();
+        atom_seconds * self.nuclide.decay_constant()
+    }
+}
@@ -767,6 +767,97 @@ impl<'l> NuclideMixture<'l> {
     }
 }
 
+#[cfg(feature = "std")]
+use crate::lines::nuclide_key;
+
+#[cfg(feature = "std")]
+impl<'l> NuclideMixture<'l> {
+    /// Solves the mixture and returns it's immutable, thread-safe solved form
+    ///
+    /// See [`crate::solved`] for details
+    #[inline]
+    pub fn solve(&self) -> crate::solved::SolvedMixture<'l> {
+        crate::solved::SolvedMixture::new(self)
+    }
+
+    /// Activity at `time` of the solution nuclide at `index`
+    ///
+    /// This involves no nuclide lookup, see [`SolutionIndex`](crate::ordinal::SolutionIndex) to obtain indices
+    ///
+    /// ### Returns
+    /// [`Option::None`] if `index` is out of range of [`NuclideMixture::decayed_to_nuclides_evolutions`]
+    #[inline]
+    pub fn activity_by_solution_index(&self, time: f64, index: usize) -> Option<f64> {
+        self.decayed_to_nuclides_evolutions()
+            .get(index)
+            .map(|evolution| evolution.activity(time))
+    }
+
+    /// Number of atoms at `time` of the solution nuclide at `index`
+    ///
+    /// Same as [`NuclideMixture::activity_by_solution_index`]
+    #[inline]
+    pub fn num_atoms_by_solution_index(&self, time: f64, index: usize) -> Option<f64> {
+        self.decayed_to_nuclides_evolutions()
+            .get(index)
+            .map(|evolution| evolution.num_atoms(time))
+    }
+
+    /// Number of decays of the `nuclide` in the time interval $[t_0; t_1]$
+    ///
+    /// Unlike subtracting atom counts, this is exact for nuclides fed by their parents (and for branching chains): activity is integrated analytically, see [`NuclideTimeEvolution::num_decays`]
+    ///
+    /// ### Returns
+    /// [`Option::None`] if nuclide is not among the solution nuclides
+    pub fn num_decays(&self, t0: f64, t1: f64, nuclide: &Nuclide<'_>) -> Option<f64> {
+        self.decayed_to_nuclides_evolutions()
+            .iter()
+            .find(|evolution| nuclide_key(evolution.nuclide) == nuclide_key(nuclide))
+            .map(|evolution| evolution.num_decays(t0, t1))
+    }
+
+    /// Writes number of decays of every solution nuclide in the time interval $[t_0; t_1]$ into `out`
+    ///
+    /// Nuclides are ordered as in [`NuclideMixture::decayed_to_nuclides_evolutions`]
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to [`NuclideMixture::num_solution_nuclides`]
+    pub fn num_decays_into(&self, t0: f64, t1: f64, out: &mut [f64]) {
+        self.num_decays_in_intervals_into(&[(t0, t1)], out);
+    }
+
+    /// Writes number of decays of every solution nuclide in each of `intervals` into `out`
+    ///
+    /// Output is (intervals × solution nuclides), with nuclides ordered as in [`NuclideMixture::decayed_to_nuclides_evolutions`]. Evolution terms and decay constants are loaded once for the whole batch
+    ///
+    /// ### Panics
+    /// If `out` length is not equal to number of intervals times [`NuclideMixture::num_solution_nuclides`]
+    pub fn num_decays_in_intervals_into(&self, intervals: &[(f64, f64)], out: &mut [f64]) {
+        let evolutions = self.decayed_to_nuclides_evolutions();
+        let nuclides = evolutions.len();
+        assert_eq!(
+            out.len(),
+            intervals.len() * nuclides,
+            "output should match intervals and nuclides"
+        );
+        out.fill(0.0);
+        for (position, evolution) in evolutions.iter().enumerate() {
+            let decay_constant = evolution.nuclide.decay_constant();
+            if decay_constant == 0.0 {
+                continue;
+            }
+            for term in evolution.evolution_terms.as_slice() {
+                for (&(t0, t1), out) in intervals.iter().zip(out.chunks_exact_mut(nuclides)) {
+                    out[position] += term.integral(t0, t1);
+                }
+            }
+            for out in out.chunks_exact_mut(nuclides) {
+                out[position] *= decay_constant;
+            }
+        }
+    }
+}
+
 containers! { NuclideMixture['l]: sdecay_sys::sdecay::nuclide_mixture::activity =>
     /// Returns nuclide activities in the mixture after a certain time
     activities(time: f64 => time) -> super::VecNuclideActivityPair['l]
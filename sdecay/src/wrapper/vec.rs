@@ -53,6 +53,23 @@ impl VecChar {
         unsafe { C::init_ptr(allocator, init) }
     }
 
+    /// Appends `data` to the end of the vector in bulk, forwarded to <https://cplusplus.com/reference/vector/vector/insert/>
+    pub fn extend_from_slice(self: core::pin::Pin<&mut Self>, data: &[u8]) {
+        // SAFETY: obtained pointer will only be used to append data to the std::vector
+        let self_ptr = unsafe { self.bindgen_ptr_mut() };
+        // SAFETY: ffi call with
+        // - statically validated type representations
+        // - correct pointer constness (as of bindgen, that is)
+        // - `self_ptr` points to a live vector, and `data` defines a valid slice of bytes on Rust side
+        unsafe {
+            sdecay_sys::sdecay::std_vector_char_extend(
+                self_ptr,
+                data.as_ptr().cast::<c_char>(),
+                data.len(),
+            );
+        }
+    }
+
     /// Same as [`Self::from_bytes_in`], but obtains `C::Allocator` from it's [`Default`] implementation
     pub fn from_bytes<C: Container<Inner = Self>>(bytes: impl AsRef<[u8]>) -> C
     where
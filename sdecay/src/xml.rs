@@ -0,0 +1,158 @@
+//! Minimal scanner of XML tags and attributes
+//!
+//! This is not a general XML parser: it only splits input into element tags with their raw attribute strings, skipping text, comments, declarations and closing tags. Entities are not expanded. This is enough for flat, machine-written data such as database files and patches.
+//!
+//! All the scanning is done with byte searches (`memchr`-style, word-at-a-time in `core`), never char-by-char. Numbers are parsed with `core`'s float parser, which is exact (correctly rounded, Eisel-Lemire with a big-decimal fallback) and does not depend on locale.
+//!
+//! Unsafe: no
+
+use core::ops::Range;
+
+/// Element tag
+#[derive(Debug, Clone, Copy)]
+pub(crate) struct Tag<'s> {
+    /// Element name
+    pub(crate) name: &'s str,
+    /// Raw attributes, e.g. `a="1" b='2'`
+    attributes: &'s str,
+    /// Byte offset of the tag in the input
+    pub(crate) offset: usize,
+    /// Tag is self-closing, e.g. `<a/>`
+    #[cfg_attr(not(feature = "std"), allow(dead_code))]
+    pub(crate) is_empty: bool,
+}
+
+impl<'s> Tag<'s> {
+    /// Iterates over `(name, value)` attribute pairs
+    ///
+    /// Iteration stops at the first malformed attribute
+    pub(crate) fn attributes(&self) -> impl Iterator<Item = (&'s str, &'s str)> + 's {
+        let mut rest = self.attributes;
+        core::iter::from_fn(move || {
+            let (name, tail) = rest.trim_start().split_once('=')?;
+            let tail = tail.trim_start();
+            let quote = tail.chars().next().filter(|&c| c == '"' || c == '\'')?;
+            let (value, tail) = tail[1..].split_once(quote)?;
+            rest = tail;
+            Some((name.trim(), value))
+        })
+    }
+
+    /// Value of attribute `name`
+    pub(crate) fn attribute(&self, name: &str) -> Option<&'s str> {
+        self.attributes()
+            .find(|&(attribute, _)| attribute == name)
+            .map(|(_, value)| value)
+    }
+}
+
+/// Iterates over element tags of `input`
+///
+/// ### Returns
+/// Iterator of tags; [`Result::Err`] contains byte offset of unterminated construct, and ends iteration
+pub(crate) fn tags(input: &str) -> Tags<'_> {
+    Tags { input, position: 0 }
+}
+
+/// Iterator over element tags, see [`tags`]
+#[derive(Debug, Clone)]
+pub(crate) struct Tags<'s> {
+    input: &'s str,
+    position: usize,
+}
+
+impl Tags<'_> {
+    /// Skips content of element `name`, that was just returned as non-empty tag, along with it's closing tag
+    ///
+    /// Element should not contain nested elements with the same name
+    ///
+    /// ### Returns
+    /// Byte range of the content; [`Option::None`] if closing tag is missing (iteration ends then)
+    #[cfg_attr(not(feature = "std"), allow(dead_code))]
+    pub(crate) fn skip_content(&mut self, name: &str) -> Option<Range<usize>> {
+        let start = self.position;
+        let mut position = start;
+        loop {
+            let Some(found) = self.input.get(position..).and_then(|rest| rest.find("</")) else {
+                self.position = self.input.len();
+                return None;
+            };
+            let close = position + found;
+            let rest = &self.input[close + 2..];
+            if let Some(tail) = rest.strip_prefix(name)
+                && let Some(length) = tail.find('>')
+                && tail[..length].trim_ascii().is_empty()
+            {
+                self.position = close + 2 + name.len() + length + 1;
+                return Some(start..close);
+            }
+            position = close + 2;
+        }
+    }
+}
+
+impl<'s> Iterator for Tags<'s> {
+    type Item = Result<Tag<'s>, usize>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let input = self.input;
+        loop {
+            let start = self.position + input.get(self.position..)?.find('<')?;
+            let rest = &input[start..];
+            let (terminator, skip) = if rest.starts_with("<!--") {
+                ("-->", true)
+            } else if rest.starts_with("<?") || rest.starts_with("<!") || rest.starts_with("</") {
+                (">", true)
+            } else {
+                (">", false)
+            };
+            let Some(length) = rest.find(terminator) else {
+                self.position = input.len();
+                return Some(Err(start));
+            };
+            self.position = start + length + terminator.len();
+            if skip {
+                continue;
+            }
+            let body = rest[1..length].trim_end_matches('/');
+            let name_end = body
+                .find(|c: char| c.is_ascii_whitespace())
+                .unwrap_or(body.len());
+            return Some(Ok(Tag {
+                name: &body[..name_end],
+                attributes: &body[name_end..],
+                offset: start,
+                is_empty: body.len() + 1 < length,
+            }));
+        }
+    }
+}
+
+/// Parses floating-point attribute `value`
+///
+/// Surrounding ASCII whitespace is ignored. Only decimal notation (with optional sign, fraction and exponent) and `inf`/`infinity`/`nan` are accepted; for these, the result is correctly rounded, same as of glibc's `strtod`. Unlike `strtod`, values with trailing garbage and hexadecimal floats are rejected, rather than read partially or in another base
+#[inline]
+pub(crate) fn parse_f64(value: &str) -> Option<f64> {
+    value.trim_ascii().parse().ok()
+}
+
+/// Parses single-precision attribute `value`
+///
+/// Value is parsed as `f64` first and then narrowed, same as `static_cast<float>(atof(value))` does. Parsing directly as `f32` rounds differently in rare halfway cases
+#[inline]
+pub(crate) fn parse_f32(value: &str) -> Option<f32> {
+    parse_f64(value).map(|value| value as f32)
+}
+
+/// Parses integer attribute `value`
+#[inline]
+pub(crate) fn parse_i16(value: &str) -> Option<i16> {
+    value.trim_ascii().parse().ok()
+}
+
+/// Parses unsigned integer attribute `value`
+#[cfg(feature = "std")]
+#[inline]
+pub(crate) fn parse_u16(value: &str) -> Option<u16> {
+    value.trim_ascii().parse().ok()
+}
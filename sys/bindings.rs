@@ -2093,6 +2093,14 @@ pub mod root {
             #[link_name = "\u{1}_ZN6sdecay24std_vector_char_destructEPSt6vectorIcSaIcEE"]
             pub fn std_vector_char_destruct(self_: *mut root::sdecay::char_vec);
         }
+        unsafe extern "C" {
+            #[link_name = "\u{1}_ZN6sdecay22std_vector_char_extendEPSt6vectorIcSaIcEEPKcm"]
+            pub fn std_vector_char_extend(
+                self_: *mut root::sdecay::char_vec,
+                data: *const ::core::ffi::c_char,
+                len: usize,
+            );
+        }
         pub type transition_vec = root::__BindgenOpaqueArray<u64, 3usize>;
         #[repr(C)]
         pub struct _dummy_transition_vec {
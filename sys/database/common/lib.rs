@@ -44,3 +44,36 @@ pub fn download(url: &str) {
         }
     }
 }
+
+/// Compresses downloaded database into `database.xml.zst` next to it
+#[cfg(feature = "zstd")]
+pub fn compress() {
+    // slow, but it's a one-off build step, and the result is embedded into every binary
+    const LEVEL: i32 = 19;
+    let out_dir = PathBuf::from(var_os("OUT_DIR").expect("should have a cargo output dir"));
+    let database =
+        File::open(out_dir.join("database.xml")).expect("should be able to open database file");
+    let compressed = File::options()
+        .create(true)
+        .write(true)
+        .truncate(true)
+        .open(out_dir.join("database.xml.zst"))
+        .expect("should be able to open compressed database file");
+    let mut encoder = zstd::Encoder::new(BufWriter::new(compressed), LEVEL)
+        .expect("should be able to create zstd encoder");
+    // lets decoder pre-size it's buffer
+    encoder
+        .set_pledged_src_size(Some(
+            database
+                .metadata()
+                .expect("should be able to stat database file")
+                .len(),
+        ))
+        .expect("should be able to set content size");
+    std::io::copy(&mut std::io::BufReader::new(database), &mut encoder)
+        .expect("should be able to compress database");
+    encoder
+        .finish()
+        .and_then(|mut writer| writer.flush())
+        .expect("should be able to write compressed database");
+}
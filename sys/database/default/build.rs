@@ -8,5 +8,7 @@ fn main() {
         println!("cargo::rustc-cfg=docsrs");
     } else {
         sandia_decay_database_common::download(URL);
+        #[cfg(feature = "zstd")]
+        sandia_decay_database_common::compress();
     }
 }
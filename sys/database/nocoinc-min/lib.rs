@@ -8,3 +8,8 @@ use pathsep::{join_path, path_separator};
 pub const FILE: &[u8] = include_bytes!(join_path!(env!("OUT_DIR"), "database.xml"));
 #[cfg(docsrs)]
 pub const FILE: &[u8] = &[];
+
+#[cfg(all(feature = "zstd", not(docsrs)))]
+pub const FILE_ZST: &[u8] = include_bytes!(join_path!(env!("OUT_DIR"), "database.xml.zst"));
+#[cfg(all(feature = "zstd", docsrs))]
+pub const FILE_ZST: &[u8] = &[];
@@ -52,6 +52,18 @@ pub mod database {
     /// Size: about 6MiB
     #[cfg(feature = "database-nocoinc-min")]
     pub const DATABASE_NOCOINC_MIN: &[u8] = sandia_decay_database_nocoinc_min::FILE;
+
+    /// Zstandard-compressed [`DATABASE`]
+    #[cfg(all(feature = "database", feature = "zstd"))]
+    pub const DATABASE_ZST: &[u8] = sandia_decay_database::FILE_ZST;
+
+    /// Zstandard-compressed [`DATABASE_MIN`]
+    #[cfg(all(feature = "database-min", feature = "zstd"))]
+    pub const DATABASE_MIN_ZST: &[u8] = sandia_decay_database_min::FILE_ZST;
+
+    /// Zstandard-compressed [`DATABASE_NOCOINC_MIN`]
+    #[cfg(all(feature = "database-nocoinc-min", feature = "zstd"))]
+    pub const DATABASE_NOCOINC_MIN_ZST: &[u8] = sandia_decay_database_nocoinc_min::FILE_ZST;
 }
 
 #[cfg(test)]
@@ -78,6 +78,11 @@ void std_string_destruct(std::string *self) { self->~basic_string(); }
     void std_vector_##name##_destruct(name##_vec *self) { self->~vector(); }
 
 STD_VEC_OPS_DEF(char, char);
+
+void std_vector_char_extend(char_vec *self, const char *data, size_t len) {
+    self->insert(self->end(), data, data + len);
+}
+
 STD_VEC_OPS_DEF(transition, SandiaDecay::Transition);
 STD_VEC_OPS_DEF(transition_ptr, const SandiaDecay::Transition *);
 STD_VEC_OPS_DEF(rad_particle, SandiaDecay::RadParticle);
@@ -217,7 +222,7 @@ TRY_CALL_DEF(init_database, Unit, ([database, path] {
              SandiaDecay::SandiaDecayDataBase *database,
              std::string const &path);
 
-TRY_CALL_DEF(init_database_bytes, Unit, ([database, data]() mutable {
+TRY_CALL_DEF(init_database_bytes, Unit, ([database, &data]() {
                  database->initialize(data);
                  return Unit();
              }()),
@@ -43,6 +43,10 @@ void std_string_destruct(std::string *self);
     void std_vector_##name##_destruct(name##_vec *self);
 
 STD_VEC_OPS(char, char);
+
+// appends `len` bytes at `data` to the end of `self`, in bulk
+void std_vector_char_extend(char_vec *self, const char *data, size_t len);
+
 STD_VEC_OPS(transition, SandiaDecay::Transition);
 STD_VEC_OPS(transition_ptr, const SandiaDecay::Transition *);
 STD_VEC_OPS(rad_particle, SandiaDecay::RadParticle);